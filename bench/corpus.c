@@ -0,0 +1,375 @@
+#include "corpus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CORPUS_MAX_DEPTH 32
+#define CORPUS_LINE_MAX 4096    // Longer than any line a generator writes
+
+// ============================================================================
+// Generator State
+// ============================================================================
+
+typedef struct {
+    char* buf;
+    size_t length;
+    uint64_t rng;
+    int depth;          // Open blocks, for indentation
+} CorpusGen;
+
+// splitmix64: tiny, fast and the same on every platform
+static uint64_t next_random(CorpusGen* gen) {
+    uint64_t z = (gen->rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static unsigned below(CorpusGen* gen, unsigned n) {
+    return (unsigned)(next_random(gen) % n);
+}
+
+static int chance(CorpusGen* gen, unsigned percent) {
+    return below(gen, 100) < percent;
+}
+
+static void put(CorpusGen* gen, const char* text) {
+    size_t n = strlen(text);
+    memcpy(gen->buf + gen->length, text, n);
+    gen->length += n;
+}
+
+static void put_char(CorpusGen* gen, char c) {
+    gen->buf[gen->length++] = c;
+}
+
+static void put_pick(CorpusGen* gen, const char* const* words, size_t count) {
+    put(gen, words[below(gen, (unsigned)count)]);
+}
+
+#define PUT_PICK(gen, words) put_pick((gen), (words), sizeof(words) / sizeof((words)[0]))
+
+static void put_indent(CorpusGen* gen) {
+    for (int i = 0; i < gen->depth; i++) put(gen, "    ");
+}
+
+// ============================================================================
+// Vocabulary
+// ============================================================================
+
+static const char* const TYPES[] = {"number", "decimal", "letter", "bool"};
+
+static const char* const STEMS[] = {
+    "count", "total", "index", "value", "result", "buffer", "offset", "length",
+    "node", "left", "right", "parent", "child", "key", "item", "limit",
+    "score", "width", "height", "depth", "cursor", "token", "state", "flag",
+};
+
+static const char* const WORDS[] = {
+    "the", "lexer", "reads", "each", "line", "and", "keeps", "track", "of",
+    "where", "tokens", "start", "so", "that", "errors", "can", "point", "back",
+    "to", "source", "this", "loop", "walks", "every", "element", "once",
+    "TODO:", "handle", "empty", "input", "carefully", "before", "returning",
+};
+
+static const char* const BINARY_OPS[] = {
+    "+", "-", "*", "/", "%", "~", "^", "==", "!=", ">", "<", ">=", "<=", "&&", "||",
+};
+
+static const char* const ASSIGN_OPS[] = {"=", "+=", "-=", "*=", "/=", "%=", "~="};
+
+static const char* const ESCAPES[] = {"\\n", "\\t", "\\\"", "\\\\", "\\0", "\\r", "\\'"};
+
+// An identifier: one or two stems, sometimes a numeric suffix or camelCase
+static void put_identifier(CorpusGen* gen) {
+    PUT_PICK(gen, STEMS);
+    if (chance(gen, 40)) {
+        const char* second = STEMS[below(gen, sizeof(STEMS) / sizeof(STEMS[0]))];
+        if (chance(gen, 30)) {
+            put_char(gen, (char)(second[0] - 'a' + 'A'));
+            put(gen, second + 1);
+        } else {
+            put_char(gen, '_');
+            put(gen, second);
+        }
+    }
+    if (chance(gen, 30)) {
+        char digits[8];
+        snprintf(digits, sizeof(digits), "%u", below(gen, 1000));
+        put(gen, digits);
+    }
+}
+
+static void put_number(CorpusGen* gen) {
+    char text[32];
+    if (chance(gen, 70)) {
+        snprintf(text, sizeof(text), "%u", below(gen, chance(gen, 80) ? 1000 : 4000000000u));
+    } else {
+        snprintf(text, sizeof(text), "%u.%u", below(gen, 10000), below(gen, 100000));
+    }
+    put(gen, text);
+}
+
+static void put_string(CorpusGen* gen) {
+    put_char(gen, '"');
+    unsigned words = 1 + below(gen, 6);
+    for (unsigned i = 0; i < words; i++) {
+        if (i > 0) put_char(gen, ' ');
+        PUT_PICK(gen, WORDS);
+        if (chance(gen, 10)) PUT_PICK(gen, ESCAPES);
+    }
+    put_char(gen, '"');
+}
+
+static void put_char_literal(CorpusGen* gen) {
+    put_char(gen, '\'');
+    put_char(gen, (char)('a' + below(gen, 26)));
+    put_char(gen, '\'');
+}
+
+static void put_literal(CorpusGen* gen) {
+    switch (below(gen, 6)) {
+        case 0: put_string(gen); break;
+        case 1: put_char_literal(gen); break;
+        case 2: put(gen, chance(gen, 50) ? "true" : "false"); break;
+        default: put_number(gen); break;
+    }
+}
+
+static void put_operand(CorpusGen* gen, unsigned literal_percent) {
+    if (chance(gen, literal_percent)) {
+        put_literal(gen);
+    } else {
+        put_identifier(gen);
+    }
+}
+
+// A flat or parenthesised expression of `terms` operands
+static void put_expression(CorpusGen* gen, unsigned terms, int spaced, unsigned literal_percent) {
+    int open = 0;
+    for (unsigned i = 0; i < terms; i++) {
+        if (i > 0) {
+            if (spaced) put_char(gen, ' ');
+            PUT_PICK(gen, BINARY_OPS);
+            if (spaced) put_char(gen, ' ');
+        }
+        if (open < 4 && i + 2 < terms && chance(gen, 20)) {
+            put_char(gen, '(');
+            open++;
+        }
+        if (chance(gen, 8)) put_char(gen, chance(gen, 50) ? '-' : '!');
+        put_operand(gen, literal_percent);
+        if (open > 0 && chance(gen, 30)) {
+            put_char(gen, ')');
+            open--;
+        }
+    }
+    while (open-- > 0) put_char(gen, ')');
+}
+
+// ============================================================================
+// Lines
+// ============================================================================
+
+typedef enum {
+    LINE_DECLARATION,
+    LINE_ASSIGNMENT,
+    LINE_CALL,
+    LINE_DENSE_EXPRESSION,
+    LINE_COMMENT,
+    LINE_LITERALS,
+    LINE_OPEN_BLOCK,
+    LINE_CLOSE_BLOCK,
+    LINE_BLANK,
+    LINE_KIND_COUNT
+} LineKind;
+
+static void emit_line(CorpusGen* gen, LineKind kind) {
+    // Depth 1 is the start/end block, which corpus_generate() closes
+    if (kind == LINE_CLOSE_BLOCK && gen->depth <= 1) kind = LINE_ASSIGNMENT;
+    if (kind == LINE_OPEN_BLOCK && gen->depth == CORPUS_MAX_DEPTH) kind = LINE_CLOSE_BLOCK;
+
+    if (kind == LINE_CLOSE_BLOCK) gen->depth--;
+    if (kind != LINE_BLANK) put_indent(gen);
+
+    switch (kind) {
+        case LINE_DECLARATION:
+            if (chance(gen, 20)) put(gen, "const ");
+            PUT_PICK(gen, TYPES);
+            put_char(gen, ' ');
+            put_identifier(gen);
+            put(gen, " = ");
+            put_expression(gen, 1 + below(gen, 3), 1, 30);
+            put_char(gen, ';');
+            break;
+
+        case LINE_ASSIGNMENT:
+            put_identifier(gen);
+            put_char(gen, ' ');
+            PUT_PICK(gen, ASSIGN_OPS);
+            put_char(gen, ' ');
+            put_expression(gen, 1 + below(gen, 4), 1, 30);
+            put_char(gen, ';');
+            break;
+
+        case LINE_CALL:
+            if (chance(gen, 40)) {
+                put(gen, "show(");
+                put_expression(gen, 1 + below(gen, 3), 1, 40);
+            } else {
+                put_identifier(gen);
+                put_char(gen, '(');
+                unsigned args = below(gen, 4);
+                for (unsigned i = 0; i < args; i++) {
+                    if (i > 0) put(gen, ", ");
+                    put_expression(gen, 1 + below(gen, 2), 1, 40);
+                }
+            }
+            put(gen, ");");
+            break;
+
+        case LINE_DENSE_EXPRESSION:
+            put_identifier(gen);
+            PUT_PICK(gen, ASSIGN_OPS);
+            put_expression(gen, 6 + below(gen, 10), 0, 25);
+            put_char(gen, ';');
+            break;
+
+        case LINE_COMMENT: {
+            put_char(gen, '#');
+            unsigned words = 3 + below(gen, 14);
+            for (unsigned i = 0; i < words; i++) {
+                put_char(gen, ' ');
+                PUT_PICK(gen, WORDS);
+            }
+            break;
+        }
+
+        case LINE_LITERALS: {
+            put(gen, "show(");
+            unsigned count = 2 + below(gen, 5);
+            for (unsigned i = 0; i < count; i++) {
+                if (i > 0) put(gen, " + ");
+                put_literal(gen);
+            }
+            put(gen, ");");
+            break;
+        }
+
+        case LINE_OPEN_BLOCK:
+            if (chance(gen, 60)) {
+                put(gen, "if (");
+                put_expression(gen, 1 + below(gen, 3), 1, 30);
+            } else {
+                put(gen, "repeat (");
+                put_identifier(gen);
+                put(gen, " = 0; ");
+                put_expression(gen, 1 + below(gen, 2), 1, 30);
+                put(gen, "; ");
+                put_identifier(gen);
+                put(gen, " += 1");
+            }
+            put(gen, ") {");
+            gen->depth++;
+            break;
+
+        case LINE_CLOSE_BLOCK:
+            put_char(gen, '}');
+            break;
+
+        case LINE_BLANK:
+        case LINE_KIND_COUNT:
+            break;
+    }
+    put_char(gen, '\n');
+}
+
+// Relative weight of each line kind, per mix
+static const unsigned MIX_WEIGHTS[CORPUS_MIX_COUNT][LINE_KIND_COUNT] = {
+    //                      decl assign call dense comment literal open close blank
+    [CORPUS_MIXED]       = {  15,   20,   15,    5,     10,     10,   8,    8,    9},
+    [CORPUS_IDENTIFIERS] = {  35,   30,   25,    0,      2,      0,   3,    3,    2},
+    [CORPUS_OPERATORS]   = {   5,   15,    0,   70,      0,      0,   4,    4,    2},
+    [CORPUS_COMMENTS]    = {   5,    5,    5,    0,     75,      0,   2,    2,    6},
+    [CORPUS_LITERALS]    = {  15,    5,    5,    0,      2,     65,   3,    3,    2},
+    [CORPUS_INDENTED]    = {   8,   15,    8,    0,      4,      5,  28,   22,   10},
+};
+
+static LineKind pick_line(CorpusGen* gen, CorpusMix mix) {
+    const unsigned* weights = MIX_WEIGHTS[mix];
+    unsigned total = 0;
+    for (int kind = 0; kind < LINE_KIND_COUNT; kind++) total += weights[kind];
+
+    unsigned roll = below(gen, total);
+    for (int kind = 0; kind < LINE_KIND_COUNT; kind++) {
+        if (roll < weights[kind]) return (LineKind)kind;
+        roll -= weights[kind];
+    }
+    return LINE_BLANK;
+}
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+static const char* const MIX_NAMES[CORPUS_MIX_COUNT] = {
+    [CORPUS_MIXED]       = "mixed",
+    [CORPUS_IDENTIFIERS] = "identifiers",
+    [CORPUS_OPERATORS]   = "operators",
+    [CORPUS_COMMENTS]    = "comments",
+    [CORPUS_LITERALS]    = "literals",
+    [CORPUS_INDENTED]    = "indented",
+};
+
+const char* corpus_mix_name(CorpusMix mix) {
+    return MIX_NAMES[mix];
+}
+
+int corpus_mix_parse(const char* name, CorpusMix* mix) {
+    for (int i = 0; i < CORPUS_MIX_COUNT; i++) {
+        if (strcmp(name, MIX_NAMES[i]) == 0) {
+            *mix = (CorpusMix)i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Bytes needed to close `depth` open blocks (the outermost being
+// start/end) from where the text stands
+static size_t closing_length(int depth) {
+    size_t length = sizeof("end\n") - 1;
+    for (int d = 1; d < depth; d++) {
+        length += 4 * (size_t)d + 2;
+    }
+    return length;
+}
+
+char* corpus_generate(CorpusMix mix, size_t size, uint64_t seed, size_t* length) {
+    // The smallest corpus is "start\n" and "end\n"; past that, lines are
+    // added while one more, and closing every block it might open, fits
+    size_t capacity = (size + CORPUS_LINE_MAX + closing_length(CORPUS_MAX_DEPTH + 1) + 64) & ~(size_t)63;
+    char* buf = (char*)aligned_alloc(64, capacity);
+    if (!buf) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for %zu byte corpus\n", size);
+        exit(1);
+    }
+
+    CorpusGen gen = {buf, 0, seed, 0};
+
+    // Every mix is one program body, so the corpus parses as well as lexes
+    put(&gen, "start\n");
+    gen.depth = 1;
+    while (gen.length + CORPUS_LINE_MAX + closing_length(gen.depth + 1) <= size) {
+        emit_line(&gen, pick_line(&gen, mix));
+    }
+    while (gen.depth > 1) emit_line(&gen, LINE_CLOSE_BLOCK);
+    gen.depth = 0;
+    put(&gen, "end\n");
+
+    // The terminator, and a zeroed tail for the lexer's vector loads
+    memset(buf + gen.length, 0, capacity - gen.length);
+    *length = gen.length;
+    return buf;
+}
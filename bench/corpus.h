@@ -0,0 +1,37 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Synthetic Corpus
+// ============================================================================
+//
+// Deterministic .ec source text for benchmarking: the same mix, size and
+// seed always give the same bytes. Every mix is built from whole lines of
+// plausible code, weighted towards what it is named after, so the lexer
+// meets realistic token lengths rather than one pathological pattern.
+
+typedef enum {
+    CORPUS_MIXED = 0,       // Roughly test.ec's balance of everything
+    CORPUS_IDENTIFIERS,     // Declarations and calls, long names
+    CORPUS_OPERATORS,       // Expressions with little whitespace
+    CORPUS_COMMENTS,        // Mostly '#' lines
+    CORPUS_LITERALS,        // Numbers, strings (some escaped) and chars
+    CORPUS_INDENTED,        // Nested blocks up to 32 levels deep
+    CORPUS_MIX_COUNT
+} CorpusMix;
+
+const char* corpus_mix_name(CorpusMix mix);
+
+// Parses a mix name as printed by corpus_mix_name(). Returns 0 on success.
+int corpus_mix_parse(const char* name, CorpusMix* mix);
+
+// Generates up to `size` bytes of source, a few KB short of it at most,
+// ending at a line break; below about 5 KB it is an empty program. The
+// text is NUL-terminated and zero-padded to a 64-byte boundary, as lex()
+// requires; free() it when done.
+char* corpus_generate(CorpusMix mix, size_t size, uint64_t seed, size_t* length);
+
+#endif // CORPUS_H
@@ -0,0 +1,548 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chunk_lexer.h"
+#include "corpus.h"
+#include "lexer.h"
+#include "symtab.h"
+
+// ============================================================================
+// Lexer Benchmark
+// ============================================================================
+//
+// Times lex() on synthetic corpora (bench/corpus.c) and reports throughput
+// per mix and size. Generating the text, freeing the tokens and resetting
+// the symbol table happen outside the timed region, so every repetition
+// lexes into a cold store and an empty symbol table, as a real run would.
+//
+// Built with LEX_BENCH_COUNT_ALLOCS and the matching --wrap linker flags
+// (see README.md), every malloc/calloc/realloc made during lex() is
+// counted as well.
+//
+// --relex times lexer_relex() instead, on random edits to each corpus, and
+// checks the tokens after every edit against a fresh lex() of the edited
+// text. Any mismatch is reported and fails the run.
+//
+// --chunks does the same for the push-style chunked lexer: each corpus is
+// fed in random chunks of 1 to n bytes, timed, and then fed again with the
+// same cuts while every token is checked against lex().
+
+#define BENCH_MAX_SIZES 16
+#define BENCH_MB (1024.0 * 1024.0)
+
+// Longest text a single random edit inserts
+#define BENCH_MAX_INSERT 64
+
+// ============================================================================
+// Allocation Counting
+// ============================================================================
+
+static size_t alloc_count;
+
+#ifdef LEX_BENCH_COUNT_ALLOCS
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+#endif
+
+// ============================================================================
+// Options
+// ============================================================================
+
+typedef struct {
+    int mixes[CORPUS_MIX_COUNT];    // Which mixes to run
+    size_t sizes[BENCH_MAX_SIZES];
+    size_t size_count;
+    unsigned reps;
+    uint64_t seed;
+    ScannerKind scanner;
+    unsigned jobs;
+    int unicode_identifiers;
+    const char* emit_dir;           // Also save each corpus here
+    unsigned relex_edits;           // Time this many lexer_relex() edits instead of lex()
+    size_t max_chunk;               // Time the chunked lexer on chunks up to this long instead
+} BenchOptions;
+
+static void print_usage(const char* prog_name) {
+    fprintf(stderr, "Usage: %s [options]\n", prog_name);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -m, --mix <name|all>  Corpus mix (repeatable) [Default: all]:\n");
+    fprintf(stderr, "                        mixed, identifiers, operators, comments, literals, indented\n");
+    fprintf(stderr, "  -n, --size <sizes>    Comma-separated sizes with K/M/G suffix [Default: 1M,64M]\n");
+    fprintf(stderr, "  -r, --reps <n>        Repetitions per corpus; the fastest is reported [Default: 5]\n");
+    fprintf(stderr, "      --seed <n>        Corpus seed [Default: 1]\n");
+    fprintf(stderr, "  -s, --switch-lexer    Use the reference switch-based scanner\n");
+    fprintf(stderr, "  -j, --jobs <n>        Lex on n threads\n");
+    fprintf(stderr, "  -u, --unicode-idents  Allow non-ASCII letters in identifiers\n");
+    fprintf(stderr, "      --emit <dir>      Also write each corpus to dir/<mix>-<size>.ec\n");
+    fprintf(stderr, "      --relex <n>       Time n random edits with lexer_relex(), checking each\n");
+    fprintf(stderr, "                        against a full lex()\n");
+    fprintf(stderr, "      --chunks <n>      Time the chunked lexer on random 1..n-byte chunks,\n");
+    fprintf(stderr, "                        checking its tokens against a full lex()\n");
+}
+
+// "64M" -> 64 << 20. Returns 0 for anything malformed.
+static size_t parse_size(const char* text) {
+    char* end;
+    unsigned long long value = strtoull(text, &end, 10);
+    switch (*end) {
+        case 'k': case 'K': value <<= 10; end++; break;
+        case 'm': case 'M': value <<= 20; end++; break;
+        case 'g': case 'G': value <<= 30; end++; break;
+        default: break;
+    }
+    return *end == '\0' || *end == ',' ? (size_t)value : 0;
+}
+
+static int parse_sizes(BenchOptions* options, const char* list) {
+    for (const char* p = list; ; p++) {
+        size_t size = parse_size(p);
+        if (size == 0 || size > TOKEN_STORE_MAX_SOURCE) return 1;
+        if (options->size_count == BENCH_MAX_SIZES) return 1;
+        options->sizes[options->size_count++] = size;
+
+        p = strchr(p, ',');
+        if (!p) return 0;
+    }
+}
+
+static void format_size(char* out, size_t out_size, size_t size) {
+    if (size % (1u << 30) == 0) {
+        snprintf(out, out_size, "%zuG", size >> 30);
+    } else if (size % (1u << 20) == 0) {
+        snprintf(out, out_size, "%zuM", size >> 20);
+    } else if (size % (1u << 10) == 0) {
+        snprintf(out, out_size, "%zuK", size >> 10);
+    } else {
+        snprintf(out, out_size, "%zu", size);
+    }
+}
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    double seconds;     // Fastest repetition
+    size_t tokens;
+    size_t allocs;      // During the fastest repetition
+} BenchResult;
+
+static BenchResult run_lexer(const BenchOptions* options, char* source, size_t length) {
+    BenchResult best = {0, 0, 0};
+    for (unsigned rep = 0; rep < options->reps; rep++) {
+        Lexer lexer;
+        memset(&lexer, 0, sizeof(Lexer));
+        lexer.start_tok = source;
+        lexer.cur_tok = source;
+        lexer.length = length;
+        lexer.scanner = options->scanner;
+        lexer.threads = options->jobs;
+        lexer.unicode_identifiers = options->unicode_identifiers;
+
+        size_t allocs_before = alloc_count;
+        double start = now_seconds();
+        if (lex(&lexer) != 0) {
+            fprintf(stderr, "Fatal Error: Lexing failed.\n");
+            exit(1);
+        }
+        double seconds = now_seconds() - start;
+        size_t allocs = alloc_count - allocs_before;
+
+        if (rep == 0 || seconds < best.seconds) {
+            best.seconds = seconds;
+            best.tokens = lexer.tokens.count;
+            best.allocs = allocs;
+        }
+
+        free_lexer(&lexer);
+        symtab_free();
+    }
+    return best;
+}
+
+// ============================================================================
+// Relexing
+// ============================================================================
+
+typedef struct {
+    double seconds;     // All edits together
+    double max_seconds; // Slowest edit
+    size_t rescanned;   // New tokens, all edits together
+    size_t values_before; // Number and string slots before the first edit
+    size_t values;      // And after the last
+    size_t mismatches;  // Edits after which the tokens differ from lex()
+} RelexResult;
+
+// splitmix64, as in corpus.c
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Pieces of code an edit inserts, a few at a time. Quotes, '#' and '\n'
+// change how the rest of a line lexes, so edits reach past themselves.
+static const char* const EDIT_PIECES[] = {
+    "x", "total", "42", "3.25", " ", "\n", "+", "=", "+=", "(", ")", "{", "}",
+    ";", "\"", "'", "#", "\"a\\tb\"", "\\n", "while", "WHILE", "'c'"
+};
+#define EDIT_PIECE_COUNT (sizeof(EDIT_PIECES) / sizeof(EDIT_PIECES[0]))
+
+// Replaces a few bytes at a random spot of text[0..*length) with a few
+// random pieces, in place. The bytes after the text stay zero.
+static TextEdit random_edit(char* text, size_t* length, uint64_t* rng) {
+    char insert[BENCH_MAX_INSERT];
+    size_t insert_length = 0;
+    for (uint64_t pieces = next_random(rng) % 4; pieces > 0; pieces--) {
+        const char* piece = EDIT_PIECES[next_random(rng) % EDIT_PIECE_COUNT];
+        size_t piece_length = strlen(piece);
+        if (insert_length + piece_length > sizeof(insert)) break;
+        memcpy(insert + insert_length, piece, piece_length);
+        insert_length += piece_length;
+    }
+
+    size_t start = (size_t)(next_random(rng) % (*length + 1));
+    size_t removed = (size_t)(next_random(rng) % 8);
+    if (removed > *length - start) removed = *length - start;
+
+    memmove(text + start + insert_length, text + start + removed, *length - start - removed);
+    memcpy(text + start, insert, insert_length);
+    size_t new_length = *length - removed + insert_length;
+    if (new_length < *length) memset(text + new_length, 0, *length - new_length);
+    *length = new_length;
+
+    TextEdit edit = {start, start + removed, start + insert_length};
+    return edit;
+}
+
+static int same_token(const TokenData* a, const TokenData* b) {
+    return a->type == b->type && a->len == b->len &&
+           (a->val == b->val || (a->val && b->val && memcmp(a->val, b->val, a->len) == 0)) &&
+           a->sym == b->sym && a->loc.line == b->loc.line && a->loc.col == b->loc.col &&
+           memcmp(&a->number, &b->number, sizeof(NumberValue)) == 0;
+}
+
+static int same_tokens(Lexer* a, Lexer* b) {
+    if (a->tokens.count != b->tokens.count) return 0;
+    for (size_t i = 0; i < a->tokens.count; i++) {
+        TokenData x = lexer_token(a, i);
+        TokenData y = lexer_token(b, i);
+        if (token_store_offset(&a->tokens, i) != token_store_offset(&b->tokens, i) || !same_token(&x, &y)) return 0;
+    }
+
+    size_t pairs_a, pairs_b;
+    const BracketPair* brackets_a = token_store_brackets(&a->tokens, &pairs_a);
+    const BracketPair* brackets_b = token_store_brackets(&b->tokens, &pairs_b);
+    return pairs_a == pairs_b && (pairs_a == 0 || memcmp(brackets_a, brackets_b, pairs_a * sizeof(BracketPair)) == 0);
+}
+
+static void init_lexer(Lexer* lexer, const BenchOptions* options, char* source, size_t length) {
+    memset(lexer, 0, sizeof(Lexer));
+    lexer->start_tok = source;
+    lexer->cur_tok = source;
+    lexer->length = length;
+    lexer->scanner = options->scanner;
+    lexer->unicode_identifiers = options->unicode_identifiers;
+}
+
+// Edits happen in a private copy with room for every insertion; the
+// full lex() each edit is checked against is not timed.
+static RelexResult run_relex(const BenchOptions* options, const char* corpus, size_t length) {
+    RelexResult result = {0, 0, 0, 0, 0, 0};
+    size_t capacity = (length + (size_t)options->relex_edits * BENCH_MAX_INSERT + 64 + 63) & ~(size_t)63;
+    char* text = (char*)calloc(capacity, 1);
+    if (!text) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for relex text\n");
+        exit(1);
+    }
+    memcpy(text, corpus, length);
+    uint64_t rng = options->seed;
+
+    Lexer lexer;
+    init_lexer(&lexer, options, text, length);
+    lexer.quiet = 1;    // Edits open strings and leave stray characters
+    lex(&lexer);
+    result.values_before = lexer.tokens.number_count + lexer.tokens.string_count;
+
+    for (unsigned e = 0; e < options->relex_edits; e++) {
+        TextEdit edit = random_edit(text, &length, &rng);
+
+        double start = now_seconds();
+        TokenSplice splice = lexer_relex(&lexer, text, &edit);
+        double seconds = now_seconds() - start;
+        result.seconds += seconds;
+        if (seconds > result.max_seconds) result.max_seconds = seconds;
+        result.rescanned += splice.inserted;
+
+        Lexer fresh;
+        init_lexer(&fresh, options, text, length);
+        fresh.quiet = 1;
+        lex(&fresh);
+        if (!same_tokens(&lexer, &fresh)) {
+            if (result.mismatches == 0) {
+                fprintf(stderr, "Error: Tokens differ from lex() after edit %u (%zu..%zu -> %zu)\n",
+                        e, edit.start, edit.old_end, edit.new_end);
+            }
+            result.mismatches++;
+        }
+        free_lexer(&fresh);
+    }
+
+    result.values = lexer.tokens.number_count + lexer.tokens.string_count;
+    free_lexer(&lexer);
+    symtab_free();
+    free(text);
+    return result;
+}
+
+// ============================================================================
+// Chunked Lexing
+// ============================================================================
+
+typedef struct {
+    double seconds;     // Fastest repetition
+    size_t tokens;
+    size_t mismatches;  // Tokens that differ from lex()'s, or are missing or extra
+} ChunkResult;
+
+typedef struct {
+    Lexer* reference;   // NULL while timing
+    size_t next;        // Index of the next token in reference->tokens
+    size_t mismatches;
+} ChunkCheck;
+
+static void check_chunk_token(const TokenData* token, void* user_data) {
+    ChunkCheck* check = (ChunkCheck*)user_data;
+    size_t index = check->next++;
+    if (!check->reference) return;
+
+    if (index >= check->reference->tokens.count) {
+        check->mismatches++;
+        return;
+    }
+    TokenData expected = lexer_token(check->reference, index);
+    if (!same_token(token, &expected)) {
+        if (check->mismatches == 0) {
+            fprintf(stderr, "Error: Chunked token %zu differs from lex() at line %zu, col %zu\n",
+                    index, expected.loc.line, expected.loc.col);
+        }
+        check->mismatches++;
+    }
+}
+
+// Cuts are drawn from the same seed every time, so the checked run sees
+// the chunks that were timed.
+static size_t feed_chunks(const BenchOptions* options, const char* source, size_t length,
+                          ChunkCheck* check) {
+    ChunkLexer chunks;
+    chunk_lexer_init(&chunks, options->scanner, options->unicode_identifiers, check_chunk_token, check);
+    uint64_t rng = options->seed;
+    for (size_t at = 0; at < length; ) {
+        size_t size = 1 + (size_t)(next_random(&rng) % options->max_chunk);
+        if (size > length - at) size = length - at;
+        chunk_lexer_feed(&chunks, source + at, size);
+        at += size;
+    }
+    chunk_lexer_finish(&chunks);
+    chunk_lexer_free(&chunks);
+    return check->next;
+}
+
+static ChunkResult run_chunks(const BenchOptions* options, const char* source, size_t length) {
+    ChunkResult result = {0, 0, 0};
+    for (unsigned rep = 0; rep < options->reps; rep++) {
+        ChunkCheck count = {NULL, 0, 0};
+        double start = now_seconds();
+        result.tokens = feed_chunks(options, source, length, &count);
+        double seconds = now_seconds() - start;
+        if (rep == 0 || seconds < result.seconds) result.seconds = seconds;
+        symtab_free();
+    }
+
+    Lexer reference;
+    init_lexer(&reference, options, (char*)source, length);
+    lex(&reference);
+    ChunkCheck check = {&reference, 0, 0};
+    feed_chunks(options, source, length, &check);
+    result.mismatches = check.mismatches;
+    if (check.next < reference.tokens.count) {
+        result.mismatches += reference.tokens.count - check.next;
+    }
+    free_lexer(&reference);
+    symtab_free();
+    return result;
+}
+
+static void emit_corpus(const char* dir, const char* mix_name, const char* size_name,
+                        const char* text, size_t length) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s-%s.ec", dir, mix_name, size_name);
+    FILE* file = fopen(path, "wb");
+    if (!file || fwrite(text, 1, length, file) != length) {
+        fprintf(stderr, "Warning: Could not write corpus file '%s'\n", path);
+    }
+    if (file) fclose(file);
+}
+
+// ============================================================================
+// Main Execution
+// ============================================================================
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    memset(&options, 0, sizeof(options));
+    options.reps = 5;
+    options.seed = 1;
+    options.scanner = SCANNER_TABLE;
+    options.jobs = 1;
+    int any_mix = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--mix") == 0) && i + 1 < argc) {
+            CorpusMix mix;
+            i++;
+            if (strcmp(argv[i], "all") == 0) {
+                for (int m = 0; m < CORPUS_MIX_COUNT; m++) options.mixes[m] = 1;
+            } else if (corpus_mix_parse(argv[i], &mix) == 0) {
+                options.mixes[mix] = 1;
+            } else {
+                fprintf(stderr, "Error: Unknown corpus mix '%s'\n", argv[i]);
+                return 1;
+            }
+            any_mix = 1;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--size") == 0) && i + 1 < argc) {
+            if (parse_sizes(&options, argv[++i]) != 0) {
+                fprintf(stderr, "Error: Invalid size list '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--reps") == 0) && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            options.reps = n > 0 ? (unsigned)n : 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--switch-lexer") == 0) {
+            options.scanner = SCANNER_SWITCH;
+        } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            options.jobs = n > 0 ? (unsigned)n : 1;
+        } else if (strcmp(argv[i], "-u") == 0 || strcmp(argv[i], "--unicode-idents") == 0) {
+            options.unicode_identifiers = 1;
+        } else if (strcmp(argv[i], "--emit") == 0 && i + 1 < argc) {
+            options.emit_dir = argv[++i];
+        } else if (strcmp(argv[i], "--chunks") == 0 && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            options.max_chunk = n > 0 ? (size_t)n : 1;
+        } else if (strcmp(argv[i], "--relex") == 0 && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            options.relex_edits = n > 0 ? (unsigned)n : 1;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Warning: Unknown option '%s'\n", argv[i]);
+        }
+    }
+
+    if (!any_mix) {
+        for (int m = 0; m < CORPUS_MIX_COUNT; m++) options.mixes[m] = 1;
+    }
+    if (options.size_count == 0) {
+        parse_sizes(&options, "1M,64M");
+    }
+
+    if (options.max_chunk > 0) {
+        printf("%-12s %6s %12s %10s %10s %10s\n",
+               "mix", "size", "tokens", "MB/s", "Mtok/s", "mismatch");
+    } else if (options.relex_edits > 0) {
+        printf("%-12s %6s %8s %10s %10s %12s %10s %10s %10s\n",
+               "mix", "size", "edits", "us/edit", "max us", "tokens/edit", "values", "after", "mismatch");
+    } else {
+        printf("%-12s %6s %12s %10s %10s %8s %11s\n",
+               "mix", "size", "tokens", "MB/s", "Mtok/s", "ns/tok", "allocs/tok");
+    }
+    int failed = 0;
+
+    for (size_t s = 0; s < options.size_count; s++) {
+        char size_name[32];
+        format_size(size_name, sizeof(size_name), options.sizes[s]);
+
+        for (int m = 0; m < CORPUS_MIX_COUNT; m++) {
+            if (!options.mixes[m]) continue;
+            const char* mix_name = corpus_mix_name((CorpusMix)m);
+
+            size_t length;
+            char* source = corpus_generate((CorpusMix)m, options.sizes[s], options.seed, &length);
+            if (options.emit_dir) {
+                emit_corpus(options.emit_dir, mix_name, size_name, source, length);
+            }
+
+            if (options.max_chunk > 0) {
+                ChunkResult chunked = run_chunks(&options, source, length);
+                printf("%-12s %6s %12zu %10.1f %10.2f %10zu\n",
+                       mix_name, size_name, chunked.tokens,
+                       (double)length / BENCH_MB / chunked.seconds,
+                       (double)chunked.tokens / 1e6 / chunked.seconds, chunked.mismatches);
+                if (chunked.mismatches > 0) failed = 1;
+                fflush(stdout);
+                free(source);
+                continue;
+            }
+            if (options.relex_edits > 0) {
+                RelexResult relex = run_relex(&options, source, length);
+                double edits = (double)options.relex_edits;
+                printf("%-12s %6s %8u %10.2f %10.2f %12.1f %10zu %10zu %10zu\n",
+                       mix_name, size_name, options.relex_edits,
+                       relex.seconds * 1e6 / edits, relex.max_seconds * 1e6,
+                       (double)relex.rescanned / edits, relex.values_before, relex.values,
+                       relex.mismatches);
+                if (relex.mismatches > 0) failed = 1;
+                fflush(stdout);
+                free(source);
+                continue;
+            }
+
+            BenchResult result = run_lexer(&options, source, length);
+            double tokens = (double)result.tokens;
+
+            printf("%-12s %6s %12zu %10.1f %10.2f %8.2f ",
+                   mix_name, size_name, result.tokens,
+                   (double)length / BENCH_MB / result.seconds,
+                   tokens / 1e6 / result.seconds,
+                   result.seconds * 1e9 / tokens);
+#ifdef LEX_BENCH_COUNT_ALLOCS
+            printf("%11.6f\n", (double)result.allocs / tokens);
+#else
+            printf("%11s\n", "-");
+#endif
+            fflush(stdout);
+            free(source);
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,36 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// ============================================================================
+// Bump Arena
+// ============================================================================
+//
+// Memory is carved sequentially out of large chunks and released all at
+// once. Individual allocations are never freed.
+
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+    ArenaChunk* head;     // Chunk currently being filled
+    size_t chunk_size;    // Default size for new chunks
+} Arena;
+
+#define ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+void arena_init(Arena* arena, size_t chunk_size);
+
+// Returns memory aligned for any object type. Exits on allocation failure.
+void* arena_alloc(Arena* arena, size_t size);
+
+// Copies `length` bytes and appends a NUL terminator.
+char* arena_strndup(Arena* arena, const char* text, size_t length);
+
+// Releases every allocation at once. The newest chunk is kept and reused,
+// so an arena that is filled and reset repeatedly settles on one chunk.
+void arena_reset(Arena* arena);
+
+void arena_free(Arena* arena);
+
+#endif // ARENA_H
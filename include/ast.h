@@ -2,7 +2,10 @@
 #define AST_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
 #include "lexer.h" // Needed for TokenData in create_node_with_loc
+#include "symtab.h"
 
 // AST Node Types
 typedef enum {
@@ -34,6 +37,8 @@ typedef enum {
     NODE_IDENTIFIER
 } ASTNodeType;
 
+#define AST_NODE_TYPE_COUNT (NODE_IDENTIFIER + 1)
+
 // Forward declaration
 typedef struct ASTNode ASTNode;
 
@@ -41,8 +46,11 @@ typedef struct ASTNode ASTNode;
 // Identifier and Literal Nodes
 // ============================================================================
 
+// Names are interned: nodes carry a SymbolId and resolve it with
+// symbol_name() when printing.
+
 typedef struct {
-    char* name;
+    SymbolId name;
 } IdentifierNode;
 
 typedef struct {
@@ -55,10 +63,10 @@ typedef struct {
         LITERAL_NULL
     } literal_type;
     union {
-        int int_value;
+        int64_t int_value;
         double double_value;
         char* string_value;
-        char char_value;
+        uint32_t char_value;    // Code point
         int bool_value;
     } value;
 } LiteralNode;
@@ -104,9 +112,12 @@ typedef struct {
 
 typedef struct {
     char* param_type;
-    char* param_name;
+    SymbolId param_name;
 } ParameterNode;
 
+// A parameter array starts this long and doubles inside the arena
+#define AST_PARAM_LIST_CAPACITY 4
+
 typedef struct {
     ParameterNode** parameters;
     size_t count;
@@ -114,7 +125,7 @@ typedef struct {
 } ParameterListNode;
 
 typedef struct {
-    char* var_name;
+    SymbolId var_name;
     char* data_type;
     ASTNode* init_expr;
     int is_const;
@@ -122,7 +133,7 @@ typedef struct {
 
 typedef struct {
     char* return_type;
-    char* func_name;
+    SymbolId func_name;
     ASTNode* params;
     ASTNode* body;
 } FuncDeclNode;
@@ -136,7 +147,7 @@ typedef struct {
 } DeclStmtNode;
 
 typedef struct {
-    char* var_name;
+    SymbolId var_name;
     enum {
         ASSIGN_DIRECT,
         ASSIGN_PLUS,
@@ -149,7 +160,7 @@ typedef struct {
 } AssignStmtNode;
 
 typedef struct {
-    char* var_name;
+    SymbolId var_name; // SYMBOL_NONE when used as an expression
     char* data_type;
 } InputStmtNode;
 
@@ -179,10 +190,9 @@ typedef struct {
 // ============================================================================
 
 typedef struct {
-    char* func_name;
+    SymbolId func_name;
     ASTNode** arguments;
     size_t count;
-    size_t capacity;
 } FuncCallNode;
 
 // ============================================================================
@@ -192,13 +202,11 @@ typedef struct {
 typedef struct {
     ASTNode** statements;
     size_t count;
-    size_t capacity;
 } StatementListNode;
 
 typedef struct {
     ASTNode** args;
     size_t count;
-    size_t capacity;
 } ArgListNode;
 
 // ============================================================================
@@ -208,7 +216,6 @@ typedef struct {
 typedef struct {
     ASTNode** global_decls;
     size_t global_count;
-    size_t global_capacity;
     ASTNode* stmt_list;
 } ProgramNode;
 
@@ -216,35 +223,57 @@ typedef struct {
 // Generic AST Node
 // ============================================================================
 
+// The payload is stored inline and selected by `type`, so a tree walk
+// reads one node per visit. No payload is larger than 32 bytes, which
+// keeps a node within a 64-byte cache line. NODE_CONTINUE_STMT and
+// NODE_STOP_STMT have none.
 struct ASTNode {
     ASTNodeType type;
-    ASTNode* parent;
-    void* specific_node;
-    
     size_t line;
     size_t column;
+
+    union {
+        StatementListNode list;         // NODE_STATEMENT_LIST and NODE_BLOCK
+        ProgramNode program;
+        ParameterListNode param_list;
+        ArgListNode arg_list;
+        DeclStmtNode decl_stmt;
+        VarDeclNode var_decl;
+        FuncDeclNode func_decl;
+        AssignStmtNode assign;
+        InputStmtNode input;
+        OutputStmtNode output;
+        CondStmtNode cond;
+        IterStmtNode iter;
+        ReturnStmtNode ret;
+        FuncCallNode call;
+        BinaryExpressionNode binary;
+        UnaryExpressionNode unary;
+        LiteralNode literal;
+        IdentifierNode identifier;
+    };
 };
 
 // ============================================================================
 // AST Management Functions
 // ============================================================================
 
-// Core creation
-ASTNode* create_node(ASTNodeType type, void* specific_data);
+// Every node of a tree, with its list arrays and strings, is allocated
+// from one arena (the parser's), so the tree is released as a whole rather
+// than node by node. Lists are allocated at their final length, once
+// complete.
 
-// IMPROVEMENT: Helper to create node and set location from token in one step
-ASTNode* create_node_with_loc(ASTNodeType type, void* specific_data, TokenData loc_token);
+// Core creation: the payload starts out zeroed
+ASTNode* create_node(Arena* arena, ASTNodeType type);
 
-// Memory cleanup
-void free_ast(ASTNode* root);
+// IMPROVEMENT: Helper to create node and set location from token in one step
+ASTNode* create_node_with_loc(Arena* arena, ASTNodeType type, TokenData loc_token);
 
-// List management (Dynamic Arrays)
-void add_statement(StatementListNode* list, ASTNode* stmt);
-void add_global_decl(ProgramNode* program, ASTNode* decl);
-void add_parameter(ParameterListNode* list, ParameterNode* param);
-void add_argument(FuncCallNode* call, ASTNode* arg);
+// Memory cleanup: releases every tree allocated from `arena` at once
+void free_ast(Arena* arena);
 
 // Debugging
 void print_ast(ASTNode* node, int indent);
+const char* ast_node_type_name(ASTNodeType type);
 
 #endif // AST_H
\ No newline at end of file
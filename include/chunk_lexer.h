@@ -0,0 +1,56 @@
+#ifndef CHUNK_LEXER_H
+#define CHUNK_LEXER_H
+
+#include <stddef.h>
+
+#include "lexer.h"
+
+// ============================================================================
+// Push-Style Chunked Lexer
+// ============================================================================
+//
+// Accepts the source as a sequence of arbitrary byte chunks (e.g. socket
+// reads) and hands each completed token to a callback as soon as it is
+// known to be complete. A token is held back while its scan ends within
+// CHUNK_LEXER_LOOKAHEAD bytes of the data received so far, since the next
+// chunk could still change it: an identifier or number, a char literal, a
+// '+' that may become '+=' or a UTF-8 sequence cut in half.
+//
+// Only the held-back token is kept between chunks. A string or comment
+// the data ends in is not scanned again from its start: the chunk lexer
+// remembers how far it searched for the end and carries on from there.
+// The `val` of an emitted token may point into the internal buffer and is
+// only valid during the callback; `sym` and keyword text stay valid.
+
+// Bytes past its end that a token's scan may look at: a UTF-8 letter is
+// at most four bytes long
+#define CHUNK_LEXER_LOOKAHEAD 4
+
+typedef void (*TokenSink)(const TokenData* token, void* user_data);
+
+typedef struct {
+    Lexer lexer;        // Scans `buffer`; lines and columns carry across chunks
+    char* buffer;       // Carried-over bytes followed by the latest chunk
+    size_t length;
+    size_t capacity;
+    TokenSink sink;
+    void* user_data;
+    int finished;       // EOF has been emitted; further input is ignored
+    int in_comment;     // The data ended inside a comment; cur_tok is in it
+    size_t open_string; // If non-zero, the data ended inside the string whose quote is at
+                        // cur_tok, and this many bytes of it were searched for its end
+} ChunkLexer;
+
+// `unicode_identifiers` is the lexer option of the same name (-u).
+void chunk_lexer_init(ChunkLexer* chunks, ScannerKind scanner, int unicode_identifiers,
+                      TokenSink sink, void* user_data);
+
+// Appends `length` bytes and emits every token that is now complete.
+void chunk_lexer_feed(ChunkLexer* chunks, const char* data, size_t length);
+
+// Marks the end of input: emits the held-back tail and TOKEN_EOF.
+void chunk_lexer_finish(ChunkLexer* chunks);
+
+void chunk_lexer_free(ChunkLexer* chunks);
+
+#endif // CHUNK_LEXER_H
@@ -2,6 +2,11 @@
 #define LEXER_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "line_index.h"
+#include "symtab.h"
 
 typedef enum {
     TOKEN_NONE = 0,
@@ -84,110 +89,297 @@ typedef enum {
     TOKEN_EOF
 } Token;
 
+#define TOKEN_TYPE_COUNT (TOKEN_EOF + 1)
+
 typedef struct {
     size_t line;
     size_t col;
 } Location;
 
+// Value of a TOKEN_INTEGER or TOKEN_FLOAT, decoded while lexing
+typedef union {
+    int64_t i;      // TOKEN_INTEGER
+    double f;       // TOKEN_FLOAT
+} NumberValue;
+
+#define TOKEN_HAS_NUMBER(type) ((type) == TOKEN_INTEGER || (type) == TOKEN_FLOAT)
+
+// Text of a TOKEN_STR_LIT that is not simply the bytes between its quotes:
+// one with escape sequences, decoded while lexing
+typedef struct {
+    const char *text;
+    size_t length;
+} StringValue;
+
+// Set in the `data` of a TOKEN_STR_LIT that stores a slot in `strings`
+// rather than its length
+#define TOKEN_STRING_SLOT 0x80000000u
+#define TOKEN_HAS_STRING(type, data) ((type) == TOKEN_STR_LIT && ((data) & TOKEN_STRING_SLOT))
+
+// A '(', '{' or '[' and the closer that matches it. Bracket tokens store
+// the slot of their pair in `data`; their lexeme is the one byte at the
+// offset.
+typedef struct {
+    uint32_t open;      // Token index of the opener, or TOKEN_BRACKET_NONE for a stray closer
+    uint32_t close;     // Token index of the closer, or TOKEN_BRACKET_NONE if it is never closed
+    uint32_t depth;     // Pairs enclosing this one; 0 at the top level
+} BracketPair;
+
+#define TOKEN_BRACKET_NONE UINT32_MAX
+#define TOKEN_BRACKETS_STALE SIZE_MAX
+#define TOKEN_IS_BRACKET(type) ((unsigned)(type) - TOKEN_LPAREN <= TOKEN_RBRACKET - TOKEN_LPAREN)
+#define TOKEN_IS_OPENER(type) (TOKEN_IS_BRACKET(type) && ((type) - TOKEN_LPAREN) % 2 == 0)
+
+// A token as handed to the parser: materialised on demand from the
+// TokenStore (lexer_token) or returned directly by lex_next.
 typedef struct {
     Token type; // The type of the token
-    char *val; // The value of the token
-    Location loc; // The location of the token
-    int need_free; // Flag to indicate if val needs to be freed
+    const char *val; // Start of the lexeme; a view into the source buffer, keyword table, symbol table or decoded strings
+    size_t len; // Length of the lexeme (val is not NUL-terminated)
+    Location loc; // Where the scan of the token had got to when it was added (see lexer_token())
+    SymbolId sym; // Interned name for TOKEN_IDENTIFIER, SYMBOL_NONE otherwise
+    NumberValue number; // Value of TOKEN_INTEGER and TOKEN_FLOAT
 } TokenData;
 
+// A run of consecutive tokens of a relexed store. Offsets are kept
+// relative to `base`, so moving every token after an edit is one addition
+// per block. Blocks are split into TOKEN_BLOCK_SIZE tokens and split again
+// when they outgrow TOKEN_BLOCK_CAPACITY.
 typedef struct {
-    char *start_tok;
-    char *cur_tok;
-    TokenData *tokens;
-    size_t token_count;
+    uint32_t *offsets;  // offsets[i] + base is the token's offset, modulo 2^32
+    uint32_t *data;
+    uint8_t *types;
+    size_t count;
+    size_t first;       // Store index of the first token
+    uint32_t base;
+} TokenBlock;
+
+#define TOKEN_BLOCK_SIZE 2048
+#define TOKEN_BLOCK_CAPACITY (2 * TOKEN_BLOCK_SIZE)
+
+// Structure-of-arrays token storage, 9 bytes per token. Only what cannot
+// be recomputed is kept: the type, where the lexeme starts (as an offset
+// from Lexer.start_tok, so inputs are limited to 4 GB) and its length.
+// Identifiers store their SymbolId in `data` instead, since the length
+// is the symbol's. Numbers store the slot of their value in the sparse
+// `numbers` table; their lexeme is the digit run at the offset. String
+// literals are a view of the source unless they contain escapes; those
+// store a slot in `strings` instead (see TOKEN_STRING_SLOT). Brackets
+// store the slot of their pair in `brackets`, which is matched the first
+// time it is asked for (token_store_brackets()). Text and
+// location are derived by lexer_token(). The three per-token arrays share
+// one allocation, which starts at `offsets`, or are part of a token cache
+// file mapped by token_cache_load(). lexer_relex() splits them into
+// blocks (TokenBlock), after which tokens are read with token_store_type()
+// and its siblings, or the arrays put back with token_store_flatten().
+typedef struct {
+    uint8_t *types;     // Token; NULL while the store is in blocks
+    uint32_t *offsets;
+    uint32_t *data;     // Lexeme length, SymbolId of a TOKEN_IDENTIFIER or slot in `numbers`/`strings`/`brackets`
+    size_t count;
     size_t capacity;
-    size_t line_number;
-    char *line_start;
-} Lexer;
 
+    TokenBlock *blocks; // In token order, or NULL
+    size_t block_count;
+    size_t block_capacity;
+
+    NumberValue *numbers;
+    size_t number_count;
+    size_t number_capacity;
+
+    StringValue *strings;
+    size_t string_count;
+    size_t string_capacity;
+    Arena string_text;  // Decoded text; kept until the store is freed or compacted
+    size_t string_bytes; // Put in string_text so far, terminators included
+
+    // Entries that lexer_relex() replaced and no token refers to any more,
+    // until token_store_compact_values() drops them
+    size_t dead_numbers;
+    size_t dead_strings;
+    size_t dead_text;   // Bytes of string_text
+
+    BracketPair *brackets;  // In the order of their first token
+    size_t bracket_count;
+    size_t bracket_capacity;
+    size_t bracket_tokens;  // Token count `brackets` was matched at, or TOKEN_BRACKETS_STALE
+
+    void *mapping;      // Cache file holding the arrays, or NULL
+    size_t mapping_size;
+} TokenStore;
+
+#define TOKEN_STORE_MAX_SOURCE UINT32_MAX
+
+// Tokens to reserve before lexing `length` bytes. Ordinary code averages
+// about 4 bytes per token (test.ec: 4.2); the estimate errs high, which
+// is cheap because the untouched tail of a large block is never paged in.
+#define TOKEN_STORE_BYTES_PER_TOKEN 3
+#define TOKEN_STORE_ESTIMATE(length) ((length) / TOKEN_STORE_BYTES_PER_TOKEN + 16)
+
+// An edit to the source: bytes [start, old_end) of the previous text were
+// replaced by what is now [start, new_end).
 typedef struct {
-    const char* text;
-    Token type;
-} Keyword;
-
-//  State Definitions (FSM Internal IDs)
-typedef enum {
-    S_START = 0, 
-
-    S_A, S_AN, S_AND, 
-    S_AS, S_ASK, 
-    S_AL, S_ALS, S_ALSO,
-
-    S_B, S_BO, S_BOO, S_BOOL,
-
-    S_O, S_OR, S_OF,
-
-    S_N, S_NO, S_NOT,
-    S_NU, S_NUM, S_NUMB, S_NUMBE, S_NUMBER,
-    S_NUL, S_NULL,
-
-    S_S, S_ST, S_STA, S_STAR, S_START_KW, S_STO, S_STOP,
-    S_SH, S_SHO, S_SHOW,
-    S_SI, S_SIZ, S_SIZE, S_SIZEO, S_SIZEOF, 
-
-    S_E, S_EN, S_END, S_EL, S_ELS, S_ELSE, S_EX, S_EXI, S_EXIT,
-    S_EA, S_EAC, S_EACH,
-
-    S_C, S_CO, S_CON, 
-    S_CONS, S_CONST, 
-    S_CONT, S_CONTI, S_CONTIN, S_CONTINU, S_CONTINUE,
-
-    S_I, S_IF, 
-    S_IM, S_IMP, S_IMPO, S_IMPOR, S_IMPORT, 
-    
-    S_W, S_WH, S_WHI, S_WHIL, S_WHILE,
-    S_WO, S_WOR, S_WORD,
-
-    S_L, S_LO, S_LOO, S_LOOP,
-    S_LE, S_LET, S_LETT, S_LETTE, S_LETTER,
-    S_LES, S_LESS,
-
-    S_M, S_MA, S_MAI, S_MAIN,
-
-    S_T, S_TR, S_TRU, S_TRUE,
-    S_TH, S_THE, S_THEN,
-
-    S_F, S_FA, S_FAL, S_FALS, S_FALSE,
-
-    S_D, S_DE, S_DEC, S_DECI, S_DECIM, S_DECIMA, S_DECIMAL,
+    size_t start;
+    size_t old_end;
+    size_t new_end;
+} TextEdit;
 
-    S_G, S_GR, S_GRE, S_GREA, S_GREAT, S_GREATE, S_GREATER,
-    S_GO, S_GOT, S_GOTO, 
-
-    S_R, S_RE, S_REP, S_REPE, S_REPEA, S_REPEAT,
-    S_RET, S_RETU, S_RETUR, S_RETURN, 
-
-    S_IDENT, 
-    NUM_STATES
-} State;
-
-#define MAX_TRANSITIONS 26 
+// What lexer_relex() did: tokens [first, first + removed) of the old store
+// became [first, first + inserted), and the tokens after them moved along.
+typedef struct {
+    size_t first;
+    size_t removed;
+    size_t inserted;
+} TokenSplice;
 
+// Which main loop lex() runs. The switch scanner is the original
+// one-case-per-byte implementation, kept as a reference.
+typedef enum {
+    SCANNER_TABLE = 0,
+    SCANNER_SWITCH
+} ScannerKind;
 
-// FSM Data Structures
 typedef struct {
-    char input_char;
-    State next_state;
-} Transition;
+    char *start_tok;    // Start of the source; token offsets are relative to it
+    char *cur_tok;
+    size_t length;      // Bytes from start_tok to the terminator; lex() measures it if 0
+    TokenStore tokens;
+    ScannerKind scanner;
+    int quiet;          // Count diagnostics in `suppressed` instead of printing them
+    size_t suppressed;
+    char *token_start;  // First byte of the most recently scanned token
+    unsigned threads;   // lex() splits large inputs across this many threads
+    int unicode_identifiers; // Identifiers may also contain non-ASCII letters (utf8_is_letter)
+
+    // Scanning tracks no lines; lexer_location() builds this index of
+    // start_tok the first time a position is needed
+    LineIndex lines;
+    size_t line_base;   // Lines before start_tok, for buffers that begin mid-input
+    size_t column_base; // Bytes of start_tok's line before it, for buffers that begin mid-line
+} Lexer;
 
 typedef struct {
-    State id;
-    Token output; 
-    Transition transitions[MAX_TRANSITIONS];
-    int num_transitions;
-} StateNode;
+    const char* text;
+    Token type;
+    size_t length;
+} Keyword;
 
-const StateNode* get_node(State s);
+// Keyword lookup: a collision-free hash of (first, second, last, length)
+// over the lower-cased keyword text. The table in lexer.c is laid out by
+// the compiler from these constants, so a collision shows up as a
+// duplicate-initializer warning at build time.
+#define KEYWORD_TABLE_SIZE 64
+#define KEYWORD_MIN_LENGTH 2
+#define KEYWORD_MAX_LENGTH 8
+#define KEYWORD_HASH(first, second, last, length) \
+    (((unsigned)(first) + 49u * (unsigned)(second) + 23u * (unsigned)(last) + (unsigned)(length)) \
+     & (KEYWORD_TABLE_SIZE - 1))
 
 int lex(Lexer *lexer);
 
-void add_token(Lexer *lexer, Token type, char *val, int malloced);
+// Scans just far enough to return the next token, without accumulating
+// tokens in lexer->tokens. Keeps returning TOKEN_EOF once the end is reached.
+TokenData lex_next(Lexer *lexer);
+
+// Appends exactly one token to lexer->tokens. Returns 1 once that token is
+// TOKEN_EOF.
+int lex_step(Lexer *lexer);
+
+// Lexes the whole buffer on up to `threads` threads (lex_parallel.c). The
+// result, including diagnostics and their order, matches lex().
+int lex_parallel(Lexer *lexer, unsigned threads);
+
+// Updates the tokens of a fully lexed buffer after an edit (relex.c).
+// `source` is the whole edited text, under the same terms as for lex(), and
+// replaces start_tok. Only tokens from just before the edit are scanned
+// again, until the new tokens line up with the old ones after it. Values
+// of replaced tokens are reused or reclaimed, so the side tables stay in
+// proportion to the tokens over any number of edits; decoded string text
+// viewed before a relex may move.
+TokenSplice lexer_relex(Lexer *lexer, char *source, const TextEdit *edit);
+
+int lex_table(Lexer *lexer);
+
+int lex_switch(Lexer *lexer);
+
+// Appends a token whose lexeme is start[0..len) in the source.
+void add_token(Lexer *lexer, Token type, const char *start, size_t len);
+
+// Grows the store to hold at least `capacity` tokens: exactly that many
+// when it is far ahead, otherwise by doubling.
+void token_store_reserve(TokenStore *store, size_t capacity);
+
+// Adds a value to the numbers table and returns its slot.
+uint32_t token_store_add_number(TokenStore *store, NumberValue value);
+
+// Copies `length` bytes of decoded string text into the store and returns
+// the slot of the new strings entry.
+uint32_t token_store_add_string(TokenStore *store, const char *text, size_t length);
+
+// Gives the strings entry `slot` a copy of new text. The old text is
+// counted in dead_text.
+void token_store_replace_string(TokenStore *store, uint32_t slot, const char *text, size_t length);
+
+// Rebuilds `numbers`, `strings` and their text with only the entries the
+// tokens refer to, renumbering the slots in token order. Views of decoded
+// strings taken before it are left dangling.
+void token_store_compact_values(TokenStore *store);
+
+// Removes the last token, and its value if it is a number or a decoded
+// string. Decoded text stays in the store, so a token that lex_next()
+// returned keeps pointing at valid memory.
+void token_store_pop(TokenStore *store);
+
+void token_store_free(TokenStore *store);
+
+// Type, offset and data of token `index`, in arrays or blocks alike.
+Token token_store_type(const TokenStore *store, size_t index);
+size_t token_store_offset(const TokenStore *store, size_t index);
+uint32_t token_store_data(const TokenStore *store, size_t index);
+
+// Replaces tokens [first, end) with those of `fresh`, whose offsets are
+// final, and moves the offsets of the tokens after them by `shift`, modulo
+// 2^32. The first splice splits the arrays into blocks; from then on only
+// the blocks holding replaced tokens are rewritten, and the rest each get
+// `shift` added to their base.
+void token_store_splice(TokenStore *store, size_t first, size_t end, const TokenStore *fresh, uint32_t shift);
+
+// Copies the blocks of a relexed store back into one set of arrays, for
+// whatever needs them whole. Does nothing to a store that has arrays.
+void token_store_flatten(TokenStore *store);
+
+// Pairs up the brackets of the whole store with a stack, replacing the
+// `brackets` table. A closer that does not match the innermost opener
+// closes the nearest enclosing opener of its kind, leaving the ones in
+// between unclosed; with none, it is stray. Nothing needs the table while
+// lexing, so it is left to token_store_brackets() to run this.
+void token_store_match_brackets(TokenStore *store);
+
+// The bracket table, matched first if tokens were added or relexed since
+// it last was. Tokens from lex_next() are popped again and never matched.
+const BracketPair *token_store_brackets(TokenStore *store, size_t *count);
+
+// Pair of bracket token `index`, or NULL for any other token. Skipping a
+// block is then a jump to the token after `close`.
+const BracketPair *token_store_bracket(TokenStore *store, size_t index);
+
+// Materialises token `index` of lexer->tokens. Its location is that of
+// the first byte of an operator, punctuation or EOF, the byte after an
+// identifier, keyword or number, the closing quote of a string and the
+// byte after a character literal, as the original lexer stamped them;
+// INVALID tokens take the end of their lexeme.
+TokenData lexer_token(Lexer *lexer, size_t index);
+
+// Offset just past the source text of token `index`, closing quote
+// excluded.
+size_t lexer_token_end(const Lexer *lexer, size_t index);
+
+// Same as lexer_token() without the location, which is left zeroed.
+TokenData lexer_token_view(const Lexer *lexer, size_t index);
+
+// Line and column of a source offset. The source must not change between
+// calls; whoever rewrites it clears lexer->lines.
+Location lexer_location(Lexer *lexer, size_t offset);
 
 void handle_identifier(Lexer *lexer);
 
@@ -197,14 +389,22 @@ const char *token_type_to_string(Token type);
 
 Token handle_keyword(const char *start, size_t length);
 
-const char* get_keyword_static_text(Token type);
+const Keyword *lookup_keyword(const char *word, size_t length);
 
-void printLexerTokens(const Lexer *lexer);
+const char* get_keyword_static_text(Token type);
 
 void free_lexer(Lexer *lexer);
 
 void handle_number_token(Lexer *lexer);
 
+void handle_string_literal(Lexer *lexer);
+
+void handle_char_literal(Lexer *lexer);
+
+void skip_comment(Lexer *lexer);
+
+void handle_unknown_char(Lexer *lexer);
+
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Line Index
+// ============================================================================
+//
+// The offset of every line start in a source buffer, collected in one
+// vectorized pass. Lexing only records byte offsets; a line and column are
+// worked out from them when something is about to be printed.
+
+// A run of consecutive line starts of a spliced index, kept relative to
+// `base` so that moving every line after an edit is one addition per
+// block.
+typedef struct {
+    uint32_t* starts;   // starts[i] + base is the offset, modulo 2^32
+    size_t count;
+    size_t first;       // Line of starts[0]
+    uint32_t base;
+} LineBlock;
+
+typedef struct {
+    uint32_t* starts;   // starts[i] is the offset of line i + 1; NULL while in blocks
+    size_t count;       // 0 until built
+    size_t capacity;
+    size_t hint;        // Line found by the last lookup
+    LineBlock* blocks;  // Set up by the first splice, or NULL
+    size_t block_count;
+    size_t block_capacity;
+} LineIndex;
+
+// Indexes `source` up to its NUL terminator, replacing any previous
+// contents.
+void line_index_build(LineIndex* index, const char* source);
+
+// Returns the 0-based line holding `offset`. Lookups at or just after the
+// previous one are O(1), anything else is a binary search; a spliced index
+// always searches, first for the block and then within it.
+size_t line_index_find(LineIndex* index, size_t offset);
+
+// Offset where 0-based `line` starts.
+size_t line_index_start(const LineIndex* index, size_t line);
+
+// Updates a built index of `source` after the bytes [start, old_end) of
+// the previous text became [start, new_end): the line starts inside the
+// old range are dropped, those in the new bytes added, and the ones after
+// shifted. The first splice moves the index into blocks, after which only
+// the blocks holding changed lines are rewritten.
+void line_index_splice(LineIndex* index, const char* source, size_t start,
+                       size_t old_end, size_t new_end);
+
+// Forgets the contents (count becomes 0). The array of an index that was
+// never spliced is kept for the next build.
+void line_index_clear(LineIndex* index);
+
+void line_index_free(LineIndex* index);
+
+#endif // LINE_INDEX_H
@@ -8,18 +8,44 @@
 // Parser State
 // ============================================================================
 
+// previous(), peek() and peek_ahead(parser, 2) are the widest reach of the
+// grammar: one token behind and two ahead of the current one.
+#define PARSER_WINDOW 4
+
 typedef struct {
-    TokenData* tokens;
+    Lexer* lexer;
+    int streaming;      // Pull tokens with lex_next instead of reading lexer->tokens
     size_t current;
-    size_t count;
     int has_error;
+
+    // Tokens are materialised (text and location) once, in order, into a
+    // ring indexed by absolute position. Type-only checks on a stored token
+    // array read lexer->tokens.types directly.
+    TokenData window[PARSER_WINDOW];
+    size_t pulled;      // Number of tokens materialised so far
+
+    // The tree being built, allocated from `nodes` (see free_ast()). The
+    // items of unfinished lists wait on `pending`, nested lists above
+    // their parents' items, and move into `nodes` once complete.
+    Arena nodes;
+    ASTNode** pending;
+    size_t pending_count;
+    size_t pending_capacity;
 } Parser;
 
+// Arena chunk size for the tree: large enough that a big input takes a
+// chunk every few thousand nodes
+#define PARSER_NODE_CHUNK (1024 * 1024)
+
 // ============================================================================
 // Lifecycle
 // ============================================================================
 
-Parser* parser_create(TokenData* tokens, size_t count);
+// Parses the tokens already stored in lexer->tokens (see lex()).
+Parser* parser_create(Lexer* lexer);
+// Parses while lexing, pulling tokens with lex_next().
+Parser* parser_create_streaming(Lexer* lexer);
+// Also releases the tree parse_program() built.
 void parser_destroy(Parser* parser);
 
 // ============================================================================
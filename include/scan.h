@@ -0,0 +1,44 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Vectorized Byte Scanning
+// ============================================================================
+//
+// Kernels used by the lexer to cover long runs 16 (SSE2) or 32 (AVX2, when
+// built with -mavx2) bytes per step, with a scalar fallback elsewhere.
+// Every kernel stops at the NUL terminator. Loads are aligned, so they never
+// cross into a page past the one holding the terminator.
+
+// Skips ' ', '\t', '\r' and '\n'. Returns the first other byte.
+const char *scan_blank_run(const char *p);
+
+// Returns the first '\n' or '\0' at or after p.
+const char *scan_to_newline(const char *p);
+
+// Returns the first '"', '\\' or '\0' at or after p.
+const char *scan_string_body(const char *p);
+
+// Returns the first byte that is not [A-Za-z0-9_]. *has_upper is set when
+// the span contains an upper-case letter (the identifier needs folding).
+const char *scan_ident_span(const char *p, int *has_upper);
+
+// Returns the first byte that is neither a digit nor '.'.
+const char *scan_number_span(const char *p);
+
+// Returns the first byte of the first malformed UTF-8 sequence at or after
+// p (see utf8_decode), or the terminator if there is none. ASCII is
+// skipped a block at a time.
+const char *scan_utf8_invalid(const char *p);
+
+// Appends to starts[*count..] the offset from `origin` of the byte after
+// every '\n' from p up to the terminator. Returns the terminator, or
+// earlier, at a point to resume from, when the array is about to exceed
+// `capacity` entries.
+const char *scan_line_starts(const char *origin, const char *p, uint32_t *starts,
+                             size_t *count, size_t capacity);
+
+#endif // SCAN_H
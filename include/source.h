@@ -0,0 +1,35 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+// ============================================================================
+// Source Loading
+// ============================================================================
+//
+// Regular files are memory-mapped rather than copied. Pipes, terminals and
+// "-" (standard input) cannot be mapped and are streamed into a growing
+// heap buffer instead. Either way `data[length]` is '\0' and is followed by
+// readable memory up to the end of its page, which is the contract lex()
+// and the scanning kernels rely on.
+
+typedef enum {
+    SOURCE_MAPPED,
+    SOURCE_STREAMED
+} SourceKind;
+
+typedef struct {
+    char* data;
+    size_t length;          // Bytes of input, excluding the terminator
+    SourceKind kind;
+    int is_regular_file;    // Streamed sources may still be regular files
+    size_t map_size;        // Size of the whole mapping, SOURCE_MAPPED only
+} SourceBuffer;
+
+// Loads `path`, or standard input when path is "-". Prints a diagnostic
+// and returns non-zero on failure.
+int source_load(SourceBuffer* source, const char* path);
+
+void source_free(SourceBuffer* source);
+
+#endif // SOURCE_H
@@ -0,0 +1,55 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ast.h"
+#include "lexer.h"
+#include "symtab.h"
+
+// ============================================================================
+// Statistics (--stats)
+// ============================================================================
+//
+// Shape of a run: what the tokens are made of and how big the tree is.
+// Everything is worked out afterwards from the finished token store and
+// AST, so lexing and parsing carry no counters of their own and a run
+// without --stats pays nothing.
+
+typedef struct {
+    size_t source_bytes;
+    size_t token_count;
+    size_t by_type[TOKEN_TYPE_COUNT];
+    size_t comment_bytes;       // '#' up to (not including) the line break
+    size_t whitespace_bytes;    // Between tokens and outside comments
+    size_t bracket_pairs;       // Entries of the store's bracket table
+    size_t unmatched_brackets;  // Openers never closed and stray closers
+    size_t max_bracket_depth;   // Top-level pairs are depth 1
+    SymtabStats symbols;        // Interning traffic up to the end of lexing
+} TokenStats;
+
+typedef struct {
+    size_t node_count;
+    size_t by_type[AST_NODE_TYPE_COUNT];
+    size_t bytes_by_type[AST_NODE_TYPE_COUNT]; // Node, arrays and strings
+    size_t max_depth;                          // The root is depth 1
+    size_t statement_lists;                    // STATEMENT_LIST and BLOCK nodes
+    size_t statements;                         // Their children, together
+    size_t calls;
+    size_t call_arguments;
+} AstStats;
+
+// Counts the tokens of a fully lexed lexer->tokens, matching its brackets
+// if nothing has yet, and takes the symbol table's lock counters as they
+// stand.
+void token_stats_collect(Lexer *lexer, TokenStats *stats);
+
+// Walks the tree from `root` (which may be NULL).
+void ast_stats_collect(const ASTNode *root, AstStats *stats);
+
+void token_stats_print(FILE *out, const TokenStats *stats);
+
+void ast_stats_print(FILE *out, const AstStats *stats);
+
+#endif // STATS_H
@@ -0,0 +1,59 @@
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Symbol Interning
+// ============================================================================
+//
+// Every distinct identifier is stored once in a process-wide table and
+// referred to by a compact SymbolId, so the lexer and every AST node share
+// one copy of each name and name equality is an integer compare.
+//
+// The table is split into SYMTAB_SHARDS independently locked shards chosen
+// by name hash, so lexers running on different threads can intern into the
+// same symbol space without serialising on one lock. symbol_name() and
+// symbol_length() take no lock at all.
+
+typedef uint32_t SymbolId;
+
+#define SYMTAB_SHARD_BITS 4
+#define SYMTAB_SHARDS (1u << SYMTAB_SHARD_BITS)
+
+#define SYMBOL_NONE 0 // Never returned by symbol_intern
+
+// Returns the id for the exact bytes name[0..length). Safe to call from
+// any number of threads.
+SymbolId symbol_intern(const char* name, size_t length);
+
+// Same, but interns the lower-cased form of name. Identifiers are
+// case-insensitive, so "Count" and "count" share an id.
+SymbolId symbol_intern_lower(const char* name, size_t length);
+
+// NUL-terminated text of a symbol, valid until symtab_free(). Returns NULL
+// for SYMBOL_NONE.
+const char* symbol_name(SymbolId id);
+
+size_t symbol_length(SymbolId id);
+
+size_t symbol_count(void);
+
+// Lock traffic since start-up (or the last symtab_free). A lock is counted
+// as contended when the first try-lock fails and the caller has to block.
+typedef struct {
+    size_t symbols;
+    size_t lookups;
+    size_t contended;
+    size_t shard_lookups[SYMTAB_SHARDS];
+    size_t shard_contended[SYMTAB_SHARDS];
+} SymtabStats;
+
+void symtab_stats(SymtabStats* stats);
+
+// Releases every interned name; previously returned ids become invalid.
+// Must not race with any other symtab call.
+void symtab_free(void);
+
+#endif // SYMTAB_H
@@ -0,0 +1,53 @@
+#ifndef TOKEN_CACHE_H
+#define TOKEN_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lexer.h"
+
+// ============================================================================
+// Token Cache
+// ============================================================================
+//
+// Token streams kept in a directory, one file per distinct source text, so
+// an unchanged file is hashed and mapped instead of lexed. The file name is
+// a hash of the source bytes seeded with TOKEN_CACHE_VERSION and the lexer
+// options that change the tokens; bump the version whenever the lexer's
+// output or the file layout changes.
+//
+// A file holds the token arrays exactly as a TokenStore lays them out,
+// followed by the number values, decoded strings and identifier names.
+// SymbolIds are only meaningful within one process, so identifiers are
+// stored as indices into the file's own name list and interned again on
+// load, once per distinct name. Bracket pairs are not stored; they are
+// matched again on load.
+//
+// Only sources that lex cleanly (no INVALID tokens) are cached: a hit
+// prints no diagnostics. Not available on Windows, where every lookup
+// misses.
+
+#define TOKEN_CACHE_VERSION 2
+
+typedef struct {
+    uint64_t hash;
+    uint64_t length;    // Source bytes, checked against the file too
+    uint32_t flags;     // Lexer options that affect the tokens
+} TokenCacheKey;
+
+// Hashes the `length` bytes at lexer->start_tok, for the lexer's options.
+TokenCacheKey token_cache_key(const Lexer *lexer, size_t length);
+
+// Fills the empty lexer->tokens from the cache, leaving the lexer at the
+// end of its input. Returns 1 on a hit and 0 on a miss; a missing,
+// mismatched or damaged file is a miss. The token arrays of a hit are a
+// private mapping of the file, released by token_store_free().
+int token_cache_load(const char *dir, const TokenCacheKey *key, Lexer *lexer);
+
+// Saves lexer->tokens, lexed from the keyed source, creating `dir` if
+// needed. The file appears under its final name only once complete, so
+// concurrent runs never see half of one. Prints a warning and returns
+// non-zero if it cannot be written. A relexed store is flattened first.
+int token_cache_store(const char *dir, const TokenCacheKey *key, Lexer *lexer);
+
+#endif // TOKEN_CACHE_H
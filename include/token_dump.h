@@ -0,0 +1,44 @@
+#ifndef TOKEN_DUMP_H
+#define TOKEN_DUMP_H
+
+#include "lexer.h"
+
+// ============================================================================
+// Token Dump
+// ============================================================================
+//
+// Writes lexer->tokens for the -l mode. Output is assembled in a large
+// buffer and handed to write(2) directly; a lexeme too long to be worth
+// copying goes out in the same writev(2) as the buffer in front of it.
+//
+// TOKEN_DUMP_TABLE is the human-readable table, one row per token.
+//
+// TOKEN_DUMP_JSONL is one JSON object per line:
+//   {"type":"TOKEN_INTEGER","offset":12,"line":2,"col":4,"text":"42","value":42}
+// `value` is only present for TOKEN_INTEGER and TOKEN_FLOAT (null for a
+// float that overflowed); `text` is null for TOKEN_EOF.
+//
+// TOKEN_DUMP_BINARY is little-endian throughout:
+//   header  "ECTKDUMP", u32 TOKEN_DUMP_BINARY_VERSION, u32 type count,
+//           then each type's name as u8 length + bytes, then u64 token count
+//   token   u8 type, u32 offset, u32 text length, text bytes, and an i64
+//           (TOKEN_INTEGER) or IEEE double (TOKEN_FLOAT) value
+// Types are indices into the header's name list.
+
+#define TOKEN_DUMP_BINARY_VERSION 1
+
+typedef enum {
+    TOKEN_DUMP_TABLE = 0,
+    TOKEN_DUMP_JSONL,
+    TOKEN_DUMP_BINARY
+} TokenDumpFormat;
+
+// Parses a -f argument ("table", "jsonl" or "binary"). Returns 0 on
+// success, non-zero for an unknown name.
+int token_dump_format_parse(const char *name, TokenDumpFormat *format);
+
+// Writes every token of lexer->tokens to fd. Returns 0 on success and
+// non-zero if a write failed. Locations are only worked out for JSONL.
+int token_dump(Lexer *lexer, int fd, TokenDumpFormat format);
+
+#endif // TOKEN_DUMP_H
@@ -0,0 +1,32 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// UTF-8
+// ============================================================================
+//
+// Source text is UTF-8. Everything outside string and character literals
+// is ASCII unless Unicode identifiers are enabled, so these helpers only
+// run once the scanners have met a byte >= 0x80.
+
+// Decodes the sequence at p into *code_point and returns its length, or 0
+// when it is malformed: a stray continuation byte, a truncated sequence
+// (including one cut short by the terminator), an overlong encoding, a
+// surrogate or a value above U+10FFFF.
+size_t utf8_decode(const char* p, uint32_t* code_point);
+
+// Writes the encoding of a valid code point to out and returns its length.
+size_t utf8_encode(uint32_t code_point, char out[4]);
+
+// Whether a code point is a letter that may appear in an identifier. ASCII
+// letters, plus the letters of the common scripts by block; punctuation
+// and symbols inside those blocks are left out where they are grouped.
+int utf8_is_letter(uint32_t code_point);
+
+// Length of the letter encoded at p, or 0 if p does not start one.
+size_t utf8_letter_length(const char* p);
+
+#endif // UTF8_H
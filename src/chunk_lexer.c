@@ -0,0 +1,228 @@
+#include "chunk_lexer.h"
+#include "scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_LEXER_INITIAL_CAPACITY 4096
+
+// ============================================================================
+// Buffer Management
+// ============================================================================
+
+// Drops everything before cur_tok, which has all been emitted or skipped,
+// and makes room for `extra` more bytes. The lines and columns dropped are
+// carried in line_base and column_base, and the line index is rebuilt on
+// next use.
+static void reserve(ChunkLexer* chunks, size_t extra) {
+    Lexer* lexer = &chunks->lexer;
+    size_t drop = (size_t)(lexer->cur_tok - chunks->buffer);
+
+    if (drop > 0) {
+        const char* line_start = chunks->buffer;
+        for (const char* p = chunks->buffer; (p = memchr(p, '\n', drop - (size_t)(p - chunks->buffer))) != NULL;) {
+            lexer->line_base++;
+            line_start = ++p;
+        }
+        if (line_start == chunks->buffer) {
+            lexer->column_base += drop;
+        } else {
+            lexer->column_base = (size_t)(lexer->cur_tok - line_start);
+        }
+
+        memmove(chunks->buffer, chunks->buffer + drop, chunks->length - drop + 1);
+        chunks->length -= drop;
+    }
+    line_index_clear(&lexer->lines);
+
+    if (chunks->length + extra + 1 > chunks->capacity) {
+        size_t new_capacity = chunks->capacity;
+        while (chunks->length + extra + 1 > new_capacity) {
+            new_capacity *= 2;
+        }
+        char* temp = (char*)realloc(chunks->buffer, new_capacity);
+        if (!temp) {
+            fprintf(stderr, "Fatal Error: Memory allocation failed for chunk buffer\n");
+            exit(1);
+        }
+        chunks->buffer = temp;
+        chunks->capacity = new_capacity;
+    }
+
+    lexer->start_tok = chunks->buffer;
+    lexer->cur_tok = chunks->buffer;
+}
+
+// ============================================================================
+// Draining
+// ============================================================================
+
+// Searches a string body from `p` for its closing quote, the way
+// handle_string_literal() scans it. Returns the quote, or the NUL that
+// ends the input inside the data, or NULL when the data runs out first;
+// *resume is then where to carry on, which is never between a backslash
+// and the byte it escapes.
+static const char* string_end(const char* p, const char* limit, const char** resume) {
+    for (;;) {
+        p = scan_string_body(p);
+        if (*p == '\\') {
+            if (p + 1 == limit) break;
+            if (p[1] == '\0') return p + 1;
+            p += 2;
+            continue;
+        }
+        if (p == limit) break;
+        return p;
+    }
+    *resume = p;
+    return NULL;
+}
+
+// Carries on with a comment or string the previous data ended in. Returns
+// 0 if the new data still does not finish it, leaving cur_tok where the
+// next chunk will need it.
+static int resume_open(ChunkLexer* chunks, const char* limit, int final) {
+    Lexer* lexer = &chunks->lexer;
+
+    if (chunks->in_comment) {
+        char* end = (char*)scan_to_newline(lexer->cur_tok);
+        if (end == limit && !final) {
+            lexer->cur_tok = end; // Nothing before the end is needed again
+            return 0;
+        }
+        lexer->cur_tok = *end == '\n' ? end + 1 : end;
+        chunks->in_comment = 0;
+    }
+
+    if (chunks->open_string > 0) {
+        const char* resume;
+        if (!final && !string_end(lexer->cur_tok + chunks->open_string, limit, &resume)) {
+            chunks->open_string = (size_t)(resume - lexer->cur_tok);
+            return 0;
+        }
+        chunks->open_string = 0; // Lexed in full from its quote now
+    }
+    return 1;
+}
+
+// Sets up the state for a token whose scan, begun at `start`, got too
+// close to the end of the data. Returns 1 if it is complete all the same:
+// a string that found its closing quote, or the end of input at a NUL
+// inside the data.
+static int hold(ChunkLexer* chunks, const TokenData* token, const char* start, const char* limit) {
+    Lexer* lexer = &chunks->lexer;
+
+    if (token->type == TOKEN_EOF) {
+        if (lexer->cur_tok != limit) return 1;
+
+        // Only blanks and comments were left, and only the last line can
+        // be a comment that is still open
+        const char* line = limit;
+        while (line > start && line[-1] != '\n') {
+            line--;
+        }
+        line = scan_blank_run(line);
+        chunks->in_comment = line < limit && *line == '#';
+        lexer->cur_tok = (char*)limit;
+        return 0;
+    }
+
+    // Anything in front of the token is final
+    char* token_start = lexer->token_start;
+    if (*token_start == '"') {
+        const char* resume;
+        if (string_end(token_start + 1, limit, &resume)) return 1;
+        chunks->open_string = (size_t)(resume - token_start);
+    }
+    lexer->cur_tok = token_start;
+    return 0;
+}
+
+// Emits complete tokens from the buffered text. Before the end of input a
+// token is kept back if its scan came within CHUNK_LEXER_LOOKAHEAD bytes
+// of the end; it is scanned again once more data arrives, unless it is a
+// string or comment, which only has the new bytes searched for its end
+// (resume_open()). Diagnostics are held back while a token might still be
+// scanned again.
+static void drain(ChunkLexer* chunks, int final) {
+    Lexer* lexer = &chunks->lexer;
+    const char* limit = chunks->buffer + chunks->length;
+
+    if (!resume_open(chunks, limit, final)) return;
+
+    for (;;) {
+        char* start = lexer->cur_tok;
+
+        lexer->quiet = !final;
+        lexer->suppressed = 0;
+        TokenData token = lex_next(lexer);
+
+        // A NUL inside the data is a real end of input, like it is for lex()
+        if (!final && (size_t)(limit - lexer->cur_tok) < CHUNK_LEXER_LOOKAHEAD &&
+            !hold(chunks, &token, start, limit)) {
+            break;
+        }
+
+        if (lexer->suppressed > 0) {
+            // The token is final; scan it again so its diagnostics print
+            lexer->cur_tok = start;
+            lexer->quiet = 0;
+            token = lex_next(lexer);
+        }
+
+        chunks->sink(&token, chunks->user_data);
+        if (token.type == TOKEN_EOF) {
+            chunks->finished = 1;
+            break;
+        }
+    }
+
+    lexer->quiet = 0;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+void chunk_lexer_init(ChunkLexer* chunks, ScannerKind scanner, int unicode_identifiers,
+                      TokenSink sink, void* user_data) {
+    memset(chunks, 0, sizeof(*chunks));
+    chunks->capacity = CHUNK_LEXER_INITIAL_CAPACITY;
+    chunks->buffer = (char*)malloc(chunks->capacity);
+    if (!chunks->buffer) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for chunk buffer\n");
+        exit(1);
+    }
+    chunks->buffer[0] = '\0';
+    chunks->sink = sink;
+    chunks->user_data = user_data;
+
+    chunks->lexer.start_tok = chunks->buffer;
+    chunks->lexer.cur_tok = chunks->buffer;
+    chunks->lexer.scanner = scanner;
+    chunks->lexer.unicode_identifiers = unicode_identifiers;
+}
+
+void chunk_lexer_feed(ChunkLexer* chunks, const char* data, size_t length) {
+    if (chunks->finished || length == 0) return;
+
+    reserve(chunks, length);
+    char* fresh = chunks->buffer + chunks->length;
+    memcpy(fresh, data, length);
+    chunks->length += length;
+    chunks->buffer[chunks->length] = '\0';
+
+    drain(chunks, 0);
+}
+
+void chunk_lexer_finish(ChunkLexer* chunks) {
+    if (chunks->finished) return;
+    drain(chunks, 1);
+}
+
+void chunk_lexer_free(ChunkLexer* chunks) {
+    free(chunks->buffer);
+    free_lexer(&chunks->lexer);
+    chunks->buffer = NULL;
+}
@@ -0,0 +1,223 @@
+#include "lexer.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Parallel Lexing
+// ============================================================================
+//
+// The buffer is cut into chunks that each begin right after a newline, and
+// worker threads lex the chunks speculatively, each as if its chunk began
+// at a token boundary. Lexer state at a token boundary is only the
+// position, so the speculation is right unless a token crosses the cut,
+// and the only token that can cross a newline is a string literal.
+//
+// The chunks are then stitched together in order. A chunk is accepted when
+// the previous one stopped exactly where this chunk's first token starts;
+// its tokens are appended as they are, since stored tokens only carry
+// source offsets. Otherwise (a string ran over the cut) the chunk is lexed
+// again on the calling thread from where the previous chunk really
+// stopped. Workers are quiet, and any chunk that produced a diagnostic is
+// also lexed again, so that diagnostics print once and in source order.
+
+// Below this many bytes per chunk, thread start-up costs more than it saves
+#ifndef LEX_PARALLEL_MIN_CHUNK
+#define LEX_PARALLEL_MIN_CHUNK (1024 * 1024)
+#endif
+#define LEX_PARALLEL_CHUNKS_PER_THREAD 4
+
+typedef struct {
+    char *start;            // First byte; a line start
+    char *end;              // Tokens starting here or later belong to the next chunk
+    Lexer lexer;            // Worker result
+    char *first_start;      // Where the first token starts
+    int reached_eof;
+} LexChunk;
+
+typedef struct {
+    LexChunk *chunks;
+    size_t count;
+    _Atomic size_t next;    // Next chunk to hand out
+} LexJobs;
+
+// Lexes until EOF (returns 1) or until the next token would start at or
+// after `end` (returns 0). That token is dropped again and the lexer is
+// left at its first byte. Quiet lexers only count diagnostics for the
+// tokens they keep; loud ones print them.
+static int lex_span(Lexer *lexer, const char *end, int loud, char **first_start) {
+    for (;;) {
+        char *before = lexer->cur_tok;
+        size_t suppressed = lexer->suppressed;
+
+        lexer->quiet = 1;
+        int eof = lex_step(lexer);
+
+        if (first_start && !*first_start) {
+            *first_start = lexer->token_start;
+        }
+
+        if (lexer->token_start >= end) {
+            token_store_pop(&lexer->tokens);
+            lexer->suppressed = suppressed;
+            lexer->cur_tok = lexer->token_start;
+            lexer->quiet = !loud;
+            return 0;
+        }
+
+        if (loud && lexer->suppressed != suppressed) {
+            // Keeping this token, so scan it again with diagnostics on
+            token_store_pop(&lexer->tokens);
+            lexer->suppressed = suppressed;
+            lexer->cur_tok = before;
+            lexer->quiet = 0;
+            eof = lex_step(lexer);
+        }
+
+        if (eof) {
+            lexer->quiet = !loud;
+            return 1;
+        }
+    }
+}
+
+static void lex_chunk(LexChunk *chunk) {
+    Lexer *lexer = &chunk->lexer;
+    lexer->cur_tok = chunk->start;
+    token_store_reserve(&lexer->tokens, TOKEN_STORE_ESTIMATE((size_t)(chunk->end - chunk->start)));
+    chunk->reached_eof = lex_span(lexer, chunk->end, 0, &chunk->first_start);
+}
+
+static void *lex_worker(void *arg) {
+    LexJobs *jobs = (LexJobs *)arg;
+    for (;;) {
+        size_t i = atomic_fetch_add(&jobs->next, 1);
+        if (i >= jobs->count) return NULL;
+        lex_chunk(&jobs->chunks[i]);
+    }
+}
+
+// Appends a worker's tokens. Offsets are relative to the whole source, so
+// only number values and decoded strings need moving to this store.
+static void append_tokens(Lexer *lexer, const Lexer *chunk) {
+    const TokenStore *in = &chunk->tokens;
+    TokenStore *out = &lexer->tokens;
+    if (in->count == 0) return;
+
+    token_store_reserve(out, out->count + in->count);
+    memcpy(out->types + out->count, in->types, in->count * sizeof(uint8_t));
+    memcpy(out->offsets + out->count, in->offsets, in->count * sizeof(uint32_t));
+    memcpy(out->data + out->count, in->data, in->count * sizeof(uint32_t));
+
+    if (in->number_count > 0 || in->string_count > 0) {
+        for (size_t i = out->count; i < out->count + in->count; i++) {
+            if (TOKEN_HAS_NUMBER(out->types[i])) {
+                out->data[i] = token_store_add_number(out, in->numbers[out->data[i]]);
+            } else if (TOKEN_HAS_STRING(out->types[i], out->data[i])) {
+                const StringValue *string = &in->strings[out->data[i] & ~TOKEN_STRING_SLOT];
+                out->data[i] = TOKEN_STRING_SLOT | token_store_add_string(out, string->text, string->length);
+            }
+        }
+    }
+    out->count += in->count;
+}
+
+int lex_parallel(Lexer *lexer, unsigned threads) {
+    char *source = lexer->cur_tok;
+    if (lexer->length == 0) {
+        lexer->length = strlen(lexer->start_tok);
+    }
+    size_t length = lexer->length - (size_t)(source - lexer->start_tok);
+
+    size_t wanted = (size_t)threads * LEX_PARALLEL_CHUNKS_PER_THREAD;
+    if (wanted > length / LEX_PARALLEL_MIN_CHUNK) wanted = length / LEX_PARALLEL_MIN_CHUNK;
+    if (threads < 2 || wanted < 2) {
+        token_store_reserve(&lexer->tokens, lexer->tokens.count + TOKEN_STORE_ESTIMATE(length));
+        return lexer->scanner == SCANNER_SWITCH ? lex_switch(lexer) : lex_table(lexer);
+    }
+
+    LexChunk *chunks = (LexChunk *)calloc(wanted, sizeof(LexChunk));
+    if (!chunks) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for lexer chunks\n");
+        exit(1);
+    }
+
+    // Cut points are moved forward to the next line start; cuts that land
+    // in the same line collapse.
+    size_t count = 0;
+    char *start = source;
+    for (size_t k = 1; k <= wanted; k++) {
+        char *cut = source + length + 1; // The last chunk owns the terminator
+        if (k < wanted) {
+            char *newline = memchr(source + length * k / wanted, '\n',
+                                   length - length * k / wanted);
+            if (!newline) continue;
+            cut = newline + 1;
+            if (cut <= start) continue;
+        }
+
+        LexChunk *chunk = &chunks[count++];
+        chunk->start = start;
+        chunk->end = cut;
+        chunk->lexer.start_tok = lexer->start_tok; // Offsets stay global
+        chunk->lexer.scanner = lexer->scanner;
+        chunk->lexer.unicode_identifiers = lexer->unicode_identifiers;
+        start = cut;
+    }
+    LexJobs jobs = {chunks, count, 0};
+    if (threads > count) threads = (unsigned)count;
+    pthread_t *workers = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    if (!workers) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for lexer threads\n");
+        exit(1);
+    }
+
+    // The calling thread works too; if a thread cannot be started the
+    // remaining ones simply take more chunks.
+    unsigned started = 0;
+    for (unsigned t = 1; t < threads; t++) {
+        if (pthread_create(&workers[started], NULL, lex_worker, &jobs) == 0) {
+            started++;
+        }
+    }
+    lex_worker(&jobs);
+    for (unsigned t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    free(workers);
+
+    // The workers' counts size the store exactly, unless a chunk has to be
+    // lexed again and comes out longer
+    size_t total = lexer->tokens.count;
+    for (size_t i = 0; i < count; i++) {
+        total += chunks[i].lexer.tokens.count;
+    }
+    token_store_reserve(&lexer->tokens, total);
+
+    // Stitch the chunks together in order. `lexer` always sits either at
+    // a chunk start or at a token start.
+    int done = 0;
+    for (size_t i = 0; i < count && !done; i++) {
+        LexChunk *chunk = &chunks[i];
+        Lexer *local = &chunk->lexer;
+
+        int synced = lexer->cur_tok == chunk->start || lexer->cur_tok == chunk->first_start;
+        if (synced && local->suppressed == 0) {
+            append_tokens(lexer, local);
+            done = chunk->reached_eof;
+            lexer->cur_tok = local->cur_tok;
+        } else {
+            done = lex_span(lexer, chunk->end, 1, NULL);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free_lexer(&chunks[i].lexer);
+    }
+    free(chunks);
+    lexer->quiet = 0;
+    return 0;
+}
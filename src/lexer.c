@@ -1,172 +1,416 @@
 #include "lexer.h"
+#include "scan.h"
+#include "symtab.h"
+#include "utf8.h"
 
 #include <ctype.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define DEFAULT_CHAR '\0'
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+// ============================================================================
+// Byte classes and operator table for the table-driven scanner
+// ============================================================================
+
+typedef enum {
+    CLASS_OTHER = 0, // Not valid outside literals
+    CLASS_END,       // '\0'
+    CLASS_SPACE,     // ' ', '\t', '\r', '\n'
+    CLASS_IDENT,     // Letters and '_'
+    CLASS_DIGIT,
+    CLASS_OPERATOR,  // Punctuation and operators, see OPERATORS
+    CLASS_COMMENT,   // '#'
+    CLASS_STRING,    // '"'
+    CLASS_CHAR       // '\''
+} CharClass;
+
+#define LETTER_CLASSES(c) [c] = CLASS_IDENT, [c + 32] = CLASS_IDENT
+
+static const unsigned char CHAR_CLASS[256] = {
+    ['\0'] = CLASS_END,
+    [' '] = CLASS_SPACE, ['\t'] = CLASS_SPACE, ['\r'] = CLASS_SPACE,
+    ['\n'] = CLASS_SPACE,
+    LETTER_CLASSES('A'), LETTER_CLASSES('B'), LETTER_CLASSES('C'), LETTER_CLASSES('D'),
+    LETTER_CLASSES('E'), LETTER_CLASSES('F'), LETTER_CLASSES('G'), LETTER_CLASSES('H'),
+    LETTER_CLASSES('I'), LETTER_CLASSES('J'), LETTER_CLASSES('K'), LETTER_CLASSES('L'),
+    LETTER_CLASSES('M'), LETTER_CLASSES('N'), LETTER_CLASSES('O'), LETTER_CLASSES('P'),
+    LETTER_CLASSES('Q'), LETTER_CLASSES('R'), LETTER_CLASSES('S'), LETTER_CLASSES('T'),
+    LETTER_CLASSES('U'), LETTER_CLASSES('V'), LETTER_CLASSES('W'), LETTER_CLASSES('X'),
+    LETTER_CLASSES('Y'), LETTER_CLASSES('Z'),
+    ['_'] = CLASS_IDENT,
+    ['0'] = CLASS_DIGIT, ['1'] = CLASS_DIGIT, ['2'] = CLASS_DIGIT, ['3'] = CLASS_DIGIT,
+    ['4'] = CLASS_DIGIT, ['5'] = CLASS_DIGIT, ['6'] = CLASS_DIGIT, ['7'] = CLASS_DIGIT,
+    ['8'] = CLASS_DIGIT, ['9'] = CLASS_DIGIT,
+    ['('] = CLASS_OPERATOR, [')'] = CLASS_OPERATOR, ['{'] = CLASS_OPERATOR,
+    ['}'] = CLASS_OPERATOR, ['['] = CLASS_OPERATOR, [']'] = CLASS_OPERATOR,
+    [','] = CLASS_OPERATOR, [';'] = CLASS_OPERATOR, [':'] = CLASS_OPERATOR,
+    ['.'] = CLASS_OPERATOR, ['+'] = CLASS_OPERATOR, ['-'] = CLASS_OPERATOR,
+    ['*'] = CLASS_OPERATOR, ['/'] = CLASS_OPERATOR, ['%'] = CLASS_OPERATOR,
+    ['~'] = CLASS_OPERATOR, ['?'] = CLASS_OPERATOR, ['^'] = CLASS_OPERATOR,
+    ['\\'] = CLASS_OPERATOR, ['>'] = CLASS_OPERATOR, ['<'] = CLASS_OPERATOR,
+    ['='] = CLASS_OPERATOR, ['!'] = CLASS_OPERATOR, ['&'] = CLASS_OPERATOR,
+    ['|'] = CLASS_OPERATOR,
+    ['#'] = CLASS_COMMENT,
+    ['"'] = CLASS_STRING,
+    ['\''] = CLASS_CHAR,
+};
+
+#undef LETTER_CLASSES
+
+#define IS_DIGIT(c) (CHAR_CLASS[(unsigned char)(c)] == CLASS_DIGIT)
+#define IS_BLANK(c) (CHAR_CLASS[(unsigned char)(c)] == CLASS_SPACE)
+#define IS_IDENT_CHAR(c) (CHAR_CLASS[(unsigned char)(c)] == CLASS_IDENT || IS_DIGIT(c))
+
+// An operator byte produces `single` on its own, or `pair` when it is
+// immediately followed by `second`. A lone byte that only exists as half of
+// a pair ('&', '|') is reported as an unexpected character.
+typedef struct {
+    Token single;
+    Token pair;
+    char second;
+} OperatorEntry;
+
+static const OperatorEntry OPERATORS[256] = {
+    ['('] = {TOKEN_LPAREN, TOKEN_NONE, 0},
+    [')'] = {TOKEN_RPAREN, TOKEN_NONE, 0},
+    ['{'] = {TOKEN_LBRACE, TOKEN_NONE, 0},
+    ['}'] = {TOKEN_RBRACE, TOKEN_NONE, 0},
+    ['['] = {TOKEN_LBRACKET, TOKEN_NONE, 0},
+    [']'] = {TOKEN_RBRACKET, TOKEN_NONE, 0},
+    [','] = {TOKEN_COMMA, TOKEN_NONE, 0},
+    [';'] = {TOKEN_SEMICOLON, TOKEN_NONE, 0},
+    [':'] = {TOKEN_COLON, TOKEN_NONE, 0},
+    ['.'] = {TOKEN_DOT, TOKEN_NONE, 0},
+    ['?'] = {TOKEN_QMARK, TOKEN_NONE, 0},
+    ['^'] = {TOKEN_POW, TOKEN_NONE, 0},
+    ['\\'] = {INVALID, TOKEN_NONE, 0},
+    ['+'] = {TOKEN_PLUS, TOKEN_PLUS_EQUAL, '='},
+    ['-'] = {TOKEN_MIN, TOKEN_MINUS_EQUAL, '='},
+    ['*'] = {TOKEN_MUL, TOKEN_MUL_EQUAL, '='},
+    ['/'] = {TOKEN_DIV, TOKEN_DIV_EQUAL, '='},
+    ['%'] = {TOKEN_MOD, TOKEN_MOD_EQUAL, '='},
+    ['~'] = {TOKEN_IDIV, TOKEN_IDIV_EQUAL, '='},
+    ['>'] = {TOKEN_GREATER, TOKEN_GREATEREQUAL, '='},
+    ['<'] = {TOKEN_LESS, TOKEN_LESSEQUAL, '='},
+    ['='] = {TOKEN_ASSIGN, TOKEN_IS, '='},
+    ['!'] = {TOKEN_NOT, TOKEN_ISNT, '='},
+    ['&'] = {INVALID, TOKEN_AND, '&'},
+    ['|'] = {INVALID, TOKEN_OR, '|'},
+};
+
+// Every lexical diagnostic asks here first so a caller that may rescan the
+// same bytes (the chunked lexer) can hold them back and only count them.
+static bool muted(Lexer *lexer) {
+    if (lexer->quiet) {
+        lexer->suppressed++;
+        return true;
+    }
+    return false;
+}
+
+// Scanning tracks no lines, so a diagnostic's position is only worked out
+// once it is actually printed.
+static Location locate(Lexer *lexer, const char *at) {
+    return lexer_location(lexer, (size_t)(at - lexer->start_tok));
+}
+
+// Single blanks between tokens are cheaper to step over inline; the vector
+// kernel is only worth calling once a run (indentation, blank lines) starts.
+static void skip_blank_run(Lexer *lexer) {
+    lexer->cur_tok = (char *)scan_blank_run(lexer->cur_tok);
+}
 
 int lex(Lexer *lexer) {
-    while (*lexer->cur_tok != '\0') {
+    // Callers that loaded the source pass its length; anyone else pays for
+    // one strlen() here, kept for lex_parallel()
+    if (lexer->length == 0) {
+        lexer->length = strlen(lexer->start_tok);
+    }
+
+    // lex_parallel() sizes the store once its chunks are counted
+    if (lexer->threads > 1) {
+        return lex_parallel(lexer, lexer->threads);
+    }
+
+    // One allocation up front rather than a series of doublings
+    size_t remaining = lexer->length - (size_t)(lexer->cur_tok - lexer->start_tok);
+    token_store_reserve(&lexer->tokens, lexer->tokens.count + TOKEN_STORE_ESTIMATE(remaining));
+    if (lexer->scanner == SCANNER_SWITCH) {
+        return lex_switch(lexer);
+    }
+    return lex_table(lexer);
+}
+
+// Both scanners are written as "step" functions that run until exactly one
+// token has been appended (the loop condition), so lex(), lex_next() and the
+// parallel lexer share them. They return 1 once the EOF token has been
+// produced. Each loop iteration records where it started in token_start, so
+// after a step it holds the first byte of the token just added.
+static int lex_table_step(Lexer *lexer);
+static int lex_switch_step(Lexer *lexer);
+
+int lex_step(Lexer *lexer) {
+    if (lexer->scanner == SCANNER_SWITCH) {
+        return lex_switch_step(lexer);
+    }
+    return lex_table_step(lexer);
+}
+
+// Pull interface. The token is appended to lexer->tokens as usual and then
+// popped again, so the store never grows past its first allocation and
+// lexing costs memory proportional to lookahead, not to the file. Lexing is
+// resumable at any token boundary: all state lives in the Lexer.
+TokenData lex_next(Lexer *lexer) {
+    size_t mark = lexer->tokens.count;
+    lex_step(lexer);
+
+    TokenData token = lexer_token(lexer, mark);
+
+    token_store_pop(&lexer->tokens);
+    return token;
+}
+
+int lex_table(Lexer *lexer) {
+    while (!lex_table_step(lexer)) {
+    }
+    return 0;
+}
+
+static int lex_table_step(Lexer *lexer) {
+    size_t mark = lexer->tokens.count;
+
+    while (lexer->tokens.count == mark) {
+        unsigned char c = (unsigned char)*lexer->cur_tok;
+        lexer->token_start = lexer->cur_tok;
+
+        switch (CHAR_CLASS[c]) {
+        case CLASS_END:
+            add_token(lexer, TOKEN_EOF, lexer->cur_tok, 0);
+            return 1;
+
+        case CLASS_SPACE:
+            lexer->cur_tok++;
+            if (IS_BLANK(*lexer->cur_tok)) {
+                skip_blank_run(lexer);
+            }
+            continue;
+
+        case CLASS_IDENT:
+            handle_identifier(lexer);
+            continue;
+
+        case CLASS_DIGIT:
+            handle_number_token(lexer);
+            continue;
+
+        case CLASS_OPERATOR: {
+            const OperatorEntry *op = &OPERATORS[c];
+            if (op->second != 0 && lexer->cur_tok[1] == op->second) {
+                add_token(lexer, op->pair, lexer->cur_tok, 2);
+                lexer->cur_tok += 2;
+                continue;
+            }
+            if (op->single == INVALID && op->second != 0) {
+                if (!muted(lexer)) {
+                    fprintf(stderr, "%zu: Error: Unexpected character '%c'\n", locate(lexer, lexer->cur_tok).line, c);
+                }
+            }
+            add_token(lexer, op->single, lexer->cur_tok, 1);
+            lexer->cur_tok++;
+            continue;
+        }
+
+        case CLASS_COMMENT:
+            skip_comment(lexer);
+            continue;
+
+        case CLASS_STRING:
+            handle_string_literal(lexer);
+            continue;
+
+        case CLASS_CHAR:
+            handle_char_literal(lexer);
+            continue;
+
+        default:
+            if (lexer->unicode_identifiers && utf8_letter_length(lexer->cur_tok) > 0) {
+                handle_identifier(lexer);
+                continue;
+            }
+            handle_unknown_char(lexer);
+            continue;
+        }
+    }
+    return 0;
+}
+
+// Reference scanner: one case per byte. Kept so the table-driven scanner can
+// be checked against it (--switch-lexer).
+int lex_switch(Lexer *lexer) {
+    while (!lex_switch_step(lexer)) {
+    }
+    return 0;
+}
+
+static int lex_switch_step(Lexer *lexer) {
+    size_t mark = lexer->tokens.count;
+
+    while (lexer->tokens.count == mark) {
+        lexer->token_start = lexer->cur_tok;
+        if (*lexer->cur_tok == '\0') {
+            add_token(lexer, TOKEN_EOF, lexer->cur_tok, 0);
+            return 1;
+        }
+
         switch (*lexer->cur_tok) {
         case ' ':
         case '\t': 
         case '\r': 
+        case '\n':
                 lexer->cur_tok++;
                 continue;
 
-        case '\n':
-            lexer->line_number++;
-            lexer->line_start = lexer->cur_tok + 1;
-            lexer->cur_tok++; 
-            continue;
-
         case '(':
-            add_token(lexer, TOKEN_LPAREN, "(", 0);
+            add_token(lexer, TOKEN_LPAREN, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case ')':
-            add_token(lexer, TOKEN_RPAREN, ")", 0);
+            add_token(lexer, TOKEN_RPAREN, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case '{':
-            add_token(lexer, TOKEN_LBRACE, "{", 0);
+            add_token(lexer, TOKEN_LBRACE, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case '}':
-            add_token(lexer, TOKEN_RBRACE, "}", 0);
+            add_token(lexer, TOKEN_RBRACE, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case '[':
-            add_token(lexer, TOKEN_LBRACKET, "[", 0);
+            add_token(lexer, TOKEN_LBRACKET, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case ']':
-            add_token(lexer, TOKEN_RBRACKET, "]", 0);
+            add_token(lexer, TOKEN_RBRACKET, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case ',':
-            add_token(lexer, TOKEN_COMMA, ",", 0);
+            add_token(lexer, TOKEN_COMMA, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case ';':
-            add_token(lexer, TOKEN_SEMICOLON, ";", 0);
+            add_token(lexer, TOKEN_SEMICOLON, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case '#':
-            // Skip until end of line
-            while (*lexer->cur_tok != '\n' && *lexer->cur_tok != '\0') {
-                lexer->cur_tok++;
-            }
-            // Increment line number and update line_start 
-            if (*lexer->cur_tok == '\n') {
-                lexer->line_number++;
-                lexer->line_start = lexer->cur_tok + 1;
-                lexer->cur_tok++;
-            }
+            skip_comment(lexer);
             continue;
 
         case ':':
-            add_token(lexer, TOKEN_COLON, ":", 0);
+            add_token(lexer, TOKEN_COLON, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue; 
 
         case '.':
-            add_token(lexer, TOKEN_DOT, ".", 0);
+            add_token(lexer, TOKEN_DOT, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue;
 
         case '+':
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_PLUS_EQUAL, "+=", 0); 
+                add_token(lexer, TOKEN_PLUS_EQUAL, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                add_token(lexer, TOKEN_PLUS, "+", 0);
+                add_token(lexer, TOKEN_PLUS, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
 
         case '-':
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_MINUS_EQUAL, "-=", 0); 
+                add_token(lexer, TOKEN_MINUS_EQUAL, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                add_token(lexer, TOKEN_MIN, "-", 0);
+                add_token(lexer, TOKEN_MIN, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
 
         case '*':
            if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_MUL_EQUAL, "*=", 0); 
+                add_token(lexer, TOKEN_MUL_EQUAL, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                add_token(lexer, TOKEN_MUL, "*", 0);
+                add_token(lexer, TOKEN_MUL, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
 
         case '/':
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_DIV_EQUAL, "/=", 0); 
+                add_token(lexer, TOKEN_DIV_EQUAL, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                add_token(lexer, TOKEN_DIV, "/", 0);
+                add_token(lexer, TOKEN_DIV, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
 
         case '%':
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_MOD_EQUAL, "%=", 0); 
+                add_token(lexer, TOKEN_MOD_EQUAL, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                add_token(lexer, TOKEN_MOD, "%", 0);
+                add_token(lexer, TOKEN_MOD, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
 
         case '~':
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_IDIV_EQUAL, "~=", 0); 
+                add_token(lexer, TOKEN_IDIV_EQUAL, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                add_token(lexer, TOKEN_IDIV, "~", 0);
+                add_token(lexer, TOKEN_IDIV, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
 
         case '?':
-            add_token(lexer, TOKEN_QMARK, "?", 0);
+            add_token(lexer, TOKEN_QMARK, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue;
 
         case '^':
-            add_token(lexer, TOKEN_POW,  "^", 0);
+            add_token(lexer, TOKEN_POW, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue;
 
         case '\\':
-            add_token(lexer, INVALID, "\\", 0);
+            add_token(lexer, INVALID, lexer->cur_tok, 1);
             lexer->cur_tok++;
             continue;
 
         case '>': {
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_GREATEREQUAL, ">=", 0); 
+                add_token(lexer, TOKEN_GREATEREQUAL, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                add_token(lexer, TOKEN_GREATER, ">", 0);
+                add_token(lexer, TOKEN_GREATER, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
@@ -174,10 +418,10 @@ int lex(Lexer *lexer) {
 
         case '<': {
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_LESSEQUAL,  "<=", 0); 
+                add_token(lexer, TOKEN_LESSEQUAL, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2; 
             } else {
-                add_token(lexer, TOKEN_LESS, "<", 0);
+                add_token(lexer, TOKEN_LESS, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
@@ -185,10 +429,10 @@ int lex(Lexer *lexer) {
 
         case '=': {
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_IS, "==", 0); 
+                add_token(lexer, TOKEN_IS, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                add_token(lexer, TOKEN_ASSIGN, "=", 0);
+                add_token(lexer, TOKEN_ASSIGN, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
@@ -196,10 +440,10 @@ int lex(Lexer *lexer) {
 
         case '!': {
             if (*(lexer->cur_tok + 1) == '=') {
-                add_token(lexer, TOKEN_ISNT, "!=", 0); 
+                add_token(lexer, TOKEN_ISNT, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2; 
             } else {
-                add_token(lexer, TOKEN_NOT, "!", 0);
+                add_token(lexer, TOKEN_NOT, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
@@ -207,11 +451,13 @@ int lex(Lexer *lexer) {
 
         case '&': {
             if (*(lexer->cur_tok + 1) == '&') {
-                add_token(lexer, TOKEN_AND, "&&", 0); 
+                add_token(lexer, TOKEN_AND, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                fprintf(stderr, "%zu: Error: Unexpected character '&'\n", lexer->line_number);
-                add_token(lexer, INVALID, "&", 0);
+                if (!muted(lexer)) {
+                    fprintf(stderr, "%zu: Error: Unexpected character '&'\n", locate(lexer, lexer->cur_tok).line);
+                }
+                add_token(lexer, INVALID, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
@@ -219,163 +465,889 @@ int lex(Lexer *lexer) {
 
         case '|': {
             if (*(lexer->cur_tok + 1) == '|') {
-                add_token(lexer, TOKEN_OR, "||", 0); 
+                add_token(lexer, TOKEN_OR, lexer->cur_tok, 2); 
                 lexer->cur_tok += 2;
             } else {
-                fprintf(stderr, "%zu: Error: Unexpected character '|'\n", lexer->line_number);
-                add_token(lexer, INVALID, "|", 0);
+                if (!muted(lexer)) {
+                    fprintf(stderr, "%zu: Error: Unexpected character '|'\n", locate(lexer, lexer->cur_tok).line);
+                }
+                add_token(lexer, INVALID, lexer->cur_tok, 1);
                 lexer->cur_tok++;
             }
             continue;
         }
 
-        case '"': {
-            lexer->cur_tok++;
-            char *str_start = lexer->cur_tok;
-            Token token_type = TOKEN_STR_LIT;
+        case '"':
+            handle_string_literal(lexer);
+            continue;
 
-            while (*lexer->cur_tok != '"' && *lexer->cur_tok != '\0') {
-                if (*lexer->cur_tok == '\n') {
-                    lexer->line_number++;
-                    lexer->line_start = lexer->cur_tok + 1;
-                }
-                lexer->cur_tok++;
+        case '\'':
+            handle_char_literal(lexer);
+            continue;
+
+        default: 
+            if (isalpha((unsigned char)*lexer->cur_tok) || *lexer->cur_tok == '_' ||
+                (lexer->unicode_identifiers && utf8_letter_length(lexer->cur_tok) > 0)) {
+                handle_identifier(lexer);
+                continue;
+            } else if (isdigit((unsigned char)*lexer->cur_tok)) {
+                handle_number_token(lexer);
+                continue; 
+            } else {
+                handle_unknown_char(lexer);
             }
+            break;
+         }
+    }
+    return 0;
+}
 
+void skip_comment(Lexer *lexer) {
+    // Skip until end of line
+    lexer->cur_tok = (char *)scan_to_newline(lexer->cur_tok);
+    if (*lexer->cur_tok == '\n') {
+        lexer->cur_tok++;
+    }
+}
 
-            if (*lexer->cur_tok == '\0') {
-                fprintf(stderr, "%zu: Error: Missing closing quote for string literal.\n", lexer->line_number);
-                token_type = INVALID;
-            }
-            
+// Value of the escape sequence '\\' c, or -1 when there is no such escape
+static int escape_value(char c) {
+    switch (c) {
+    case 'n':  return '\n';
+    case 't':  return '\t';
+    case 'r':  return '\r';
+    case '0':  return '\0';
+    case '\\': return '\\';
+    case '"':  return '"';
+    case '\'': return '\'';
+    default:   return -1;
+    }
+}
 
-            int str_len = lexer->cur_tok - str_start;
-            char *text = (char *)malloc(str_len + 1);
-            if (text == NULL) {
-                fprintf(stderr, "Fatal Error: Memory allocation failed for string literal\n");
-                exit(1);
+static void push_token(Lexer *lexer, Token type, const char *start, uint32_t data);
+static uint32_t decode_string(TokenStore *store, const char *p, const char *end);
+
+// The body is scanned a run at a time, up to the next quote or backslash.
+// A literal without escapes stays a view of the source; only one that has
+// them is decoded, into the token store. Since TOKEN_STRING_SLOT takes a
+// bit of the length, so is one of 2 GB or more.
+void handle_string_literal(Lexer *lexer) {
+    lexer->cur_tok++;
+    char *str_start = lexer->cur_tok;
+    Token token_type = TOKEN_STR_LIT;
+    bool escaped = false;
+
+    char *p = (char *)scan_string_body(str_start);
+    while (*p == '\\') {
+        if (p[1] == '\0') {
+            p++;
+            break;
+        }
+        if (escape_value(p[1]) < 0) {
+            if (!muted(lexer)) {
+                fprintf(stderr, "%zu: Error: Unknown escape sequence '\\%c' in string literal\n", locate(lexer, p).line, p[1]);
             }
-            
-            strncpy(text, str_start, str_len);
-            text[str_len] = '\0';
-            add_token(lexer, token_type, text, 1);
-            lexer->cur_tok++;
-            continue;
+            token_type = INVALID;
+        }
+        escaped = true;
+        p = (char *)scan_string_body(p + 2);
+    }
+    lexer->cur_tok = p;
+
+    if (*lexer->cur_tok == '\0') {
+        if (!muted(lexer)) {
+            fprintf(stderr, "%zu: Error: Missing closing quote for string literal.\n", locate(lexer, lexer->cur_tok).line);
         }
+        token_type = INVALID;
+    }
+
+    size_t len = (size_t)(lexer->cur_tok - str_start);
+    if (token_type == TOKEN_STR_LIT && (escaped || len >= TOKEN_STRING_SLOT)) {
+        push_token(lexer, token_type, str_start,
+                   TOKEN_STRING_SLOT | decode_string(&lexer->tokens, str_start, lexer->cur_tok));
+    } else {
+        add_token(lexer, token_type, str_start, len);
+    }
+    if (*lexer->cur_tok != '\0') {
+        lexer->cur_tok++; // Consume the closing quote
+    }
+}
+
+void handle_char_literal(Lexer *lexer) {
+    lexer->cur_tok++;
+    Token token_type = TOKEN_CHAR_LIT;
+
+    if (*lexer->cur_tok == '\0' || *lexer->cur_tok == '\n') {
+        if (!muted(lexer)) {
+            fprintf(stderr, "%zu: Error: Unterminated character literal.\n", locate(lexer, lexer->cur_tok).line);
+        }
+        // Do not advance `cur_tok` past '\0' or '\n' here.
+        add_token(lexer, INVALID, lexer->cur_tok - 1, 1);
+        return;
+    }
 
-        case '\'': {
+    // One character, which may take several bytes
+    char *char_start = lexer->cur_tok;
+    uint32_t code_point;
+    size_t char_len = utf8_decode(char_start, &code_point);
+    if (char_len == 0) {
+        if (!muted(lexer)) {
+            fprintf(stderr, "%zu: Error: Invalid UTF-8 in character literal.\n", locate(lexer, char_start).line);
+        }
+        token_type = INVALID;
+        char_len = 1;
+    }
+    lexer->cur_tok += char_len;
+
+    if (*lexer->cur_tok != '\'') {
+        while (*lexer->cur_tok != '\'' && *lexer->cur_tok != '\0' && *lexer->cur_tok != '\n') {
             lexer->cur_tok++;
-            Token token_type = TOKEN_CHAR_LIT;
-            
-            if (*lexer->cur_tok == '\0' || *lexer->cur_tok == '\n') {
-                fprintf(stderr, "%zu: Error: Unterminated character literal.\n", lexer->line_number);
-                // Do not advance `cur_tok` past '\0' or '\n' here.
-                add_token(lexer, INVALID, "'", 0);
-                continue;
+        }
+
+        if (!muted(lexer)) {
+            fprintf(stderr, "%zu: Error: Invalid character literal (expected exactly one character).\n",
+                    locate(lexer, lexer->cur_tok).line);
+        }
+        token_type = INVALID;
+
+        if (*lexer->cur_tok == '\'') {
+            lexer->cur_tok++; // Consume the closing quote
+        }
+    } else {
+        lexer->cur_tok++; // Consume the closing quote
+    }
+
+    // The lexeme is the single character right after the opening quote
+    add_token(lexer, token_type, char_start, char_len);
+}
+
+// A non-ASCII character is reported and skipped whole, so it makes one
+// INVALID token rather than one per byte.
+void handle_unknown_char(Lexer *lexer) {
+    uint32_t code_point;
+    size_t length = utf8_decode(lexer->cur_tok, &code_point);
+
+    if (!muted(lexer)) {
+        Location loc = locate(lexer, lexer->cur_tok);
+        if (length > 1) {
+            fprintf(stderr, "Unknown token at line %zu, col %zu: '%.*s' (U+%04X)\n",
+                    loc.line,
+                    loc.col,
+                    (int)length, lexer->cur_tok,
+                    (unsigned)code_point);
+        } else if (length == 0) {
+            fprintf(stderr, "Unknown token at line %zu, col %zu: invalid UTF-8 byte 0x%02X\n",
+                    loc.line,
+                    loc.col,
+                    (unsigned char)*lexer->cur_tok);
+        } else {
+            fprintf(stderr, "Unknown token at line %zu, col %zu: '%c' (ASCII: %d)\n", 
+                    loc.line, 
+                    loc.col,
+                    *lexer->cur_tok,
+                    (int)*lexer->cur_tok);
+        }
+    }
+    if (length == 0) length = 1;
+    add_token(lexer, INVALID, lexer->cur_tok, length);
+    lexer->cur_tok += length;
+}
+
+// The per-token arrays are one heap block, or part of a token cache mapping
+static void release_arrays(TokenStore *store) {
+#ifndef _WIN32
+    if (store->mapping) {
+        munmap(store->mapping, store->mapping_size);
+        store->mapping = NULL;
+        store->mapping_size = 0;
+        return;
+    }
+#endif
+    free(store->offsets);
+}
+
+void token_store_reserve(TokenStore *store, size_t capacity) {
+    if (capacity <= store->capacity) return;
+
+    size_t new_capacity = store->capacity * 2;
+    if (new_capacity < capacity) new_capacity = capacity;
+    if (new_capacity < 8) new_capacity = 8;
+
+    // offsets | data | types, so every array is aligned for its type
+    char *block = (char *)malloc(new_capacity * (2 * sizeof(uint32_t) + sizeof(uint8_t)));
+    if (!block) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    uint32_t *offsets = (uint32_t *)block;
+    uint32_t *data = offsets + new_capacity;
+    uint8_t *types = (uint8_t *)(data + new_capacity);
+
+    if (store->count > 0) {
+        memcpy(offsets, store->offsets, store->count * sizeof(uint32_t));
+        memcpy(data, store->data, store->count * sizeof(uint32_t));
+        memcpy(types, store->types, store->count * sizeof(uint8_t));
+    }
+    release_arrays(store);
+
+    store->offsets = offsets;
+    store->data = data;
+    store->types = types;
+    store->capacity = new_capacity;
+}
+
+uint32_t token_store_add_number(TokenStore *store, NumberValue value) {
+    if (store->number_count == store->number_capacity) {
+        size_t new_capacity = store->number_capacity == 0 ? 8 : store->number_capacity * 2;
+        NumberValue *numbers = (NumberValue *)realloc(store->numbers, new_capacity * sizeof(NumberValue));
+        if (!numbers) {
+            perror("Error reallocating memory");
+            exit(1);
+        }
+        store->numbers = numbers;
+        store->number_capacity = new_capacity;
+    }
+    store->numbers[store->number_count] = value;
+    return (uint32_t)store->number_count++;
+}
+
+#define TOKEN_STORE_STRING_CHUNK 4096
+
+static uint32_t add_string_slot(TokenStore *store, StringValue value) {
+    if (store->string_count == store->string_capacity) {
+        size_t new_capacity = store->string_capacity == 0 ? 8 : store->string_capacity * 2;
+        StringValue *strings = (StringValue *)realloc(store->strings, new_capacity * sizeof(StringValue));
+        if (!strings) {
+            perror("Error reallocating memory");
+            exit(1);
+        }
+        store->strings = strings;
+        store->string_capacity = new_capacity;
+    }
+    store->strings[store->string_count] = value;
+    store->string_bytes += value.length + 1;
+    return (uint32_t)store->string_count++;
+}
+
+// Most sources have no escapes at all, so the arena is set up on first use
+static Arena *string_arena(TokenStore *store) {
+    if (store->string_text.chunk_size == 0) {
+        arena_init(&store->string_text, TOKEN_STORE_STRING_CHUNK);
+    }
+    return &store->string_text;
+}
+
+uint32_t token_store_add_string(TokenStore *store, const char *text, size_t length) {
+    char *copy = arena_strndup(string_arena(store), text, length);
+    return add_string_slot(store, (StringValue){copy, length});
+}
+
+void token_store_replace_string(TokenStore *store, uint32_t slot, const char *text, size_t length) {
+    StringValue *string = &store->strings[slot];
+    store->dead_text += string->length + 1;
+    store->string_bytes += length + 1;
+    string->text = arena_strndup(string_arena(store), text, length);
+    string->length = length;
+}
+
+// Decodes the body [p, end) of a string literal whose escapes the lexer
+// has checked, copying the runs between backslashes as they are.
+static uint32_t decode_string(TokenStore *store, const char *p, const char *end) {
+    char *text = (char *)arena_alloc(string_arena(store), (size_t)(end - p) + 1);
+    char *out = text;
+
+    for (;;) {
+        const char *backslash = memchr(p, '\\', (size_t)(end - p));
+        const char *run_end = backslash ? backslash : end;
+        memcpy(out, p, (size_t)(run_end - p));
+        out += run_end - p;
+        if (!backslash) break;
+
+        *out++ = (char)escape_value(backslash[1]);
+        p = backslash + 2;
+    }
+    *out = '\0';
+    return add_string_slot(store, (StringValue){text, (size_t)(out - text)});
+}
+
+// Tokens are only popped while they are still the newest, so a number's
+// value or a string's entry is the last one in its table.
+void token_store_pop(TokenStore *store) {
+    store->count--;
+    uint8_t type = store->types[store->count];
+    if (TOKEN_HAS_NUMBER(type)) {
+        store->number_count--;
+    } else if (TOKEN_HAS_STRING(type, store->data[store->count])) {
+        store->string_count--;
+    }
+}
+
+// The blocks of a relexed store, or the arrays of any other seen as a
+// single block
+static const TokenBlock *token_blocks(const TokenStore *store, TokenBlock *whole, size_t *count) {
+    if (store->blocks) {
+        *count = store->block_count;
+        return store->blocks;
+    }
+    *whole = (TokenBlock){store->offsets, store->data, store->types, store->count, 0, 0};
+    *count = 1;
+    return whole;
+}
+
+// Position of the last block starting at or before token `index`; an
+// index at the end of the store falls in the last block
+static size_t block_at(const TokenStore *store, size_t index) {
+    size_t lo = 0;
+    size_t hi = store->block_count - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (store->blocks[mid].first <= index) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// Type, offset and data of one token, looked up once
+typedef struct {
+    Token type;
+    uint32_t offset;
+    uint32_t data;
+} StoredToken;
+
+static StoredToken stored_token(const TokenStore *store, size_t index) {
+    if (!store->blocks) {
+        return (StoredToken){(Token)store->types[index], store->offsets[index], store->data[index]};
+    }
+    const TokenBlock *block = &store->blocks[block_at(store, index)];
+    size_t i = index - block->first;
+    return (StoredToken){(Token)block->types[i], block->base + block->offsets[i], block->data[i]};
+}
+
+Token token_store_type(const TokenStore *store, size_t index) {
+    return stored_token(store, index).type;
+}
+
+size_t token_store_offset(const TokenStore *store, size_t index) {
+    return stored_token(store, index).offset;
+}
+
+uint32_t token_store_data(const TokenStore *store, size_t index) {
+    return stored_token(store, index).data;
+}
+
+// An empty block with room for TOKEN_BLOCK_CAPACITY tokens, its arrays
+// laid out like the store's
+static TokenBlock new_block(size_t first) {
+    char *memory = (char *)malloc(TOKEN_BLOCK_CAPACITY * (2 * sizeof(uint32_t) + sizeof(uint8_t)));
+    if (!memory) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    TokenBlock block = {0};
+    block.offsets = (uint32_t *)memory;
+    block.data = block.offsets + TOKEN_BLOCK_CAPACITY;
+    block.types = (uint8_t *)(block.data + TOKEN_BLOCK_CAPACITY);
+    block.first = first;
+    return block;
+}
+
+// Cuts `count` tokens of flat arrays into blocks of at most
+// TOKEN_BLOCK_SIZE, sized evenly; `at` receives them
+static void cut_blocks(TokenBlock *at, size_t pieces, const uint8_t *types, const uint32_t *offsets,
+                       const uint32_t *data, size_t count, size_t first) {
+    size_t from = 0;
+    for (size_t p = 0; p < pieces; p++) {
+        size_t to = count * (p + 1) / pieces;
+        at[p] = new_block(first + from);
+        at[p].count = to - from;
+        memcpy(at[p].types, types + from, (to - from) * sizeof(uint8_t));
+        memcpy(at[p].offsets, offsets + from, (to - from) * sizeof(uint32_t));
+        memcpy(at[p].data, data + from, (to - from) * sizeof(uint32_t));
+        from = to;
+    }
+}
+
+static size_t pieces_for(size_t count) {
+    return (count + TOKEN_BLOCK_SIZE - 1) / TOKEN_BLOCK_SIZE;
+}
+
+static void reserve_blocks(TokenStore *store, size_t count) {
+    if (count <= store->block_capacity) return;
+    size_t new_capacity = store->block_capacity == 0 ? 16 : store->block_capacity * 2;
+    if (new_capacity < count) new_capacity = count;
+    TokenBlock *blocks = (TokenBlock *)realloc(store->blocks, new_capacity * sizeof(TokenBlock));
+    if (!blocks) {
+        perror("Error reallocating memory");
+        exit(1);
+    }
+    store->blocks = blocks;
+    store->block_capacity = new_capacity;
+}
+
+// Moves the arrays into blocks; an empty store gets one empty block
+static void split_into_blocks(TokenStore *store) {
+    size_t pieces = pieces_for(store->count);
+    reserve_blocks(store, pieces > 0 ? pieces : 1);
+    if (pieces == 0) {
+        store->blocks[0] = new_block(0);
+        pieces = 1;
+    } else {
+        cut_blocks(store->blocks, pieces, store->types, store->offsets, store->data, store->count, 0);
+    }
+    store->block_count = pieces;
+
+    release_arrays(store);
+    store->types = NULL;
+    store->offsets = NULL;
+    store->data = NULL;
+    store->capacity = 0;
+}
+
+void token_store_splice(TokenStore *store, size_t first, size_t end, const TokenStore *fresh, uint32_t shift) {
+    if (!store->blocks) split_into_blocks(store);
+
+    size_t from = block_at(store, first);
+    size_t to = block_at(store, end);
+    TokenBlock *head = &store->blocks[from];
+    TokenBlock *tail = &store->blocks[to];
+    size_t head_keep = first - head->first;
+    size_t tail_from = end - tail->first;
+    size_t tail_count = tail->count - tail_from;
+    size_t total = head_keep + fresh->count + tail_count;
+
+    size_t after; // First block past the rewritten ones
+    if (from == to && total > 0 && total <= TOKEN_BLOCK_CAPACITY) {
+        size_t at = head_keep + fresh->count;
+        memmove(head->types + at, head->types + tail_from, tail_count * sizeof(uint8_t));
+        memmove(head->offsets + at, head->offsets + tail_from, tail_count * sizeof(uint32_t));
+        memmove(head->data + at, head->data + tail_from, tail_count * sizeof(uint32_t));
+        for (size_t i = at; i < total; i++) {
+            head->offsets[i] += shift;
+        }
+        for (size_t i = 0; i < fresh->count; i++) {
+            head->types[head_keep + i] = fresh->types[i];
+            head->offsets[head_keep + i] = fresh->offsets[i] - head->base;
+            head->data[head_keep + i] = fresh->data[i];
+        }
+        head->count = total;
+        after = from + 1;
+    } else {
+        // Join what is kept of the first and last block with the new
+        // tokens, at their final offsets, and cut that into new blocks
+        TokenStore joined;
+        memset(&joined, 0, sizeof(joined));
+        token_store_reserve(&joined, total);
+        for (size_t i = 0; i < head_keep; i++) {
+            joined.types[i] = head->types[i];
+            joined.offsets[i] = head->base + head->offsets[i];
+            joined.data[i] = head->data[i];
+        }
+        if (fresh->count > 0) {
+            memcpy(joined.types + head_keep, fresh->types, fresh->count * sizeof(uint8_t));
+            memcpy(joined.offsets + head_keep, fresh->offsets, fresh->count * sizeof(uint32_t));
+            memcpy(joined.data + head_keep, fresh->data, fresh->count * sizeof(uint32_t));
+        }
+        for (size_t i = 0; i < tail_count; i++) {
+            size_t j = head_keep + fresh->count + i;
+            joined.types[j] = tail->types[tail_from + i];
+            joined.offsets[j] = tail->base + tail->offsets[tail_from + i] + shift;
+            joined.data[j] = tail->data[tail_from + i];
+        }
+
+        size_t pieces = pieces_for(total);
+        size_t replaced = to - from + 1;
+        for (size_t b = from; b <= to; b++) {
+            free(store->blocks[b].offsets);
+        }
+        if (pieces > replaced) reserve_blocks(store, store->block_count - replaced + pieces);
+        memmove(store->blocks + from + pieces, store->blocks + to + 1,
+                (store->block_count - to - 1) * sizeof(TokenBlock));
+        cut_blocks(store->blocks + from, pieces, joined.types, joined.offsets, joined.data, total, first - head_keep);
+        store->block_count = store->block_count - replaced + pieces;
+        after = from + pieces;
+        token_store_free(&joined);
+
+        if (store->block_count == 0) {
+            store->blocks[0] = new_block(0);
+            store->block_count = 1;
+        }
+    }
+
+    for (size_t b = after; b < store->block_count; b++) {
+        store->blocks[b].base += shift;
+        store->blocks[b].first = b == 0 ? 0 : store->blocks[b - 1].first + store->blocks[b - 1].count;
+    }
+    store->count = store->count - (end - first) + fresh->count;
+}
+
+void token_store_flatten(TokenStore *store) {
+    if (!store->blocks) return;
+
+    TokenBlock *blocks = store->blocks;
+    size_t block_count = store->block_count;
+    size_t count = store->count;
+    store->blocks = NULL;
+    store->block_count = 0;
+    store->block_capacity = 0;
+    store->count = 0;
+    token_store_reserve(store, count);
+
+    for (size_t b = 0; b < block_count; b++) {
+        const TokenBlock *block = &blocks[b];
+        memcpy(store->types + block->first, block->types, block->count * sizeof(uint8_t));
+        memcpy(store->data + block->first, block->data, block->count * sizeof(uint32_t));
+        for (size_t i = 0; i < block->count; i++) {
+            store->offsets[block->first + i] = block->base + block->offsets[i];
+        }
+        free(block->offsets);
+    }
+    free(blocks);
+    store->count = count;
+}
+
+void token_store_compact_values(TokenStore *store) {
+    TokenStore live;
+    memset(&live, 0, sizeof(live));
+    TokenBlock whole;
+    size_t block_count;
+    const TokenBlock *blocks = token_blocks(store, &whole, &block_count);
+    for (size_t b = 0; b < block_count; b++) {
+        const TokenBlock *block = &blocks[b];
+        for (size_t i = 0; i < block->count; i++) {
+            if (TOKEN_HAS_NUMBER(block->types[i])) {
+                block->data[i] = token_store_add_number(&live, store->numbers[block->data[i]]);
+            } else if (TOKEN_HAS_STRING(block->types[i], block->data[i])) {
+                const StringValue *string = &store->strings[block->data[i] & ~TOKEN_STRING_SLOT];
+                block->data[i] = TOKEN_STRING_SLOT | token_store_add_string(&live, string->text, string->length);
             }
-            
-            char value = *lexer->cur_tok;
-            lexer->cur_tok++;
-            
-            if (*lexer->cur_tok != '\'') {
-                while (*lexer->cur_tok != '\'' && *lexer->cur_tok != '\0' && *lexer->cur_tok != '\n') {
-                    lexer->cur_tok++;
-                }
-                
-                fprintf(stderr, "%zu: Error: Invalid character literal (expected exactly one character).\n", lexer->line_number);
-                token_type = INVALID;
+        }
+    }
+
+    free(store->numbers);
+    free(store->strings);
+    arena_free(&store->string_text);
+    store->numbers = live.numbers;
+    store->number_count = live.number_count;
+    store->number_capacity = live.number_capacity;
+    store->strings = live.strings;
+    store->string_count = live.string_count;
+    store->string_capacity = live.string_capacity;
+    store->string_text = live.string_text;
+    store->string_bytes = live.string_bytes;
+    store->dead_numbers = 0;
+    store->dead_strings = 0;
+    store->dead_text = 0;
+}
+
+void token_store_free(TokenStore *store) {
+    release_arrays(store);
+    for (size_t b = 0; b < store->block_count; b++) {
+        free(store->blocks[b].offsets);
+    }
+    free(store->blocks);
+    free(store->numbers);
+    free(store->strings);
+    arena_free(&store->string_text);
+    free(store->brackets);
+    memset(store, 0, sizeof(*store));
+}
+
+static uint32_t add_bracket_pair(TokenStore *store, BracketPair pair) {
+    if (store->bracket_count == store->bracket_capacity) {
+        size_t new_capacity = store->bracket_capacity == 0 ? 64 : store->bracket_capacity * 2;
+        BracketPair *brackets = (BracketPair *)realloc(store->brackets, new_capacity * sizeof(BracketPair));
+        if (!brackets) {
+            perror("Error reallocating memory");
+            exit(1);
+        }
+        store->brackets = brackets;
+        store->bracket_capacity = new_capacity;
+    }
+    store->brackets[store->bracket_count] = pair;
+    return (uint32_t)store->bracket_count++;
+}
 
-                if (*lexer->cur_tok == '\'') {
-                    lexer->cur_tok++; // Consume the closing quote
+// The stack holds the slots of the open pairs, innermost last; its height
+// is the depth of the next pair. Counting the open pairs of each kind
+// means a closer only searches the stack when it will pop what it passes,
+// which keeps the whole pass linear.
+void token_store_match_brackets(TokenStore *store) {
+    uint32_t *stack = NULL;
+    size_t height = 0;
+    size_t stack_capacity = 0;
+    size_t open_of_kind[3] = {0, 0, 0};
+
+    store->bracket_count = 0;
+    TokenBlock whole;
+    size_t block_count;
+    const TokenBlock *block = token_blocks(store, &whole, &block_count);
+    for (size_t i = 0; i < store->count; i++) {
+        while (i >= block->first + block->count) block++;
+        uint32_t *data = &block->data[i - block->first];
+        uint8_t type = block->types[i - block->first];
+        if (!TOKEN_IS_BRACKET(type)) continue;
+
+        if (TOKEN_IS_OPENER(type)) {
+            if (height == stack_capacity) {
+                stack_capacity = stack_capacity == 0 ? 64 : stack_capacity * 2;
+                stack = (uint32_t *)realloc(stack, stack_capacity * sizeof(uint32_t));
+                if (!stack) {
+                    perror("Error reallocating memory");
+                    exit(1);
                 }
-            } else {
-                lexer->cur_tok++; // Consume the closing quote
             }
+            uint32_t slot = add_bracket_pair(store, (BracketPair){(uint32_t)i, TOKEN_BRACKET_NONE, (uint32_t)height});
+            stack[height++] = slot;
+            *data = slot;
+            open_of_kind[(type - TOKEN_LPAREN) / 2]++;
+            continue;
+        }
 
-            char *char_str = (char *)malloc(2);
-            if (char_str == NULL) {
-                fprintf(stderr, "Fatal Error: Memory allocation failed for character literal\n");
-                exit(1);
-            }
-            char_str[0] = value;
-            char_str[1] = '\0';
-            
-            add_token(lexer, token_type, char_str, 1);
-            free(char_str);
+        if (open_of_kind[(type - TOKEN_LPAREN) / 2] == 0) {
+            *data = add_bracket_pair(store, (BracketPair){TOKEN_BRACKET_NONE, (uint32_t)i, (uint32_t)height});
             continue;
         }
-        default: 
-            if (isalpha(*lexer->cur_tok) || *lexer->cur_tok == '_') {
-                handle_identifier(lexer);
-                continue;
-            } else if (isdigit(*lexer->cur_tok) || (*lexer->cur_tok == '.' && isdigit(*(lexer->cur_tok + 1)))) {
-                handle_number_token(lexer);
-                continue; 
-            } else {
-                fprintf(stderr, "Unknown token at line %zu, col %zu: '%c' (ASCII: %d)\n", 
-                        lexer->line_number, 
-                        lexer->cur_tok - lexer->line_start,
-                        *lexer->cur_tok,
-                        (int)*lexer->cur_tok);
-                add_token(lexer, INVALID, lexer->cur_tok, 0);
+        for (;;) {
+            uint32_t slot = stack[--height];
+            uint8_t open = (uint8_t)token_store_type(store, store->brackets[slot].open);
+            open_of_kind[(open - TOKEN_LPAREN) / 2]--;
+            if (open == type - 1) {
+                *data = slot;
+                store->brackets[slot].close = (uint32_t)i;
+                break;
             }
-            break;
-         }
+        }
     }
-    add_token(lexer, TOKEN_EOF, NULL, 0);
-    return 0;
+    free(stack);
+    store->bracket_tokens = store->count;
 }
 
-void add_token(Lexer *lexer, Token type, char *val, int malloced) {
-    if (lexer->token_count == lexer->capacity) {
-        size_t new_capacity = lexer->capacity == 0 ? 8 : lexer->capacity * 2;
-        lexer->tokens = (TokenData *)realloc(lexer->tokens, new_capacity * sizeof(TokenData));
-        if (!lexer->tokens) {
-            perror("Error reallocating memory");
-            exit(1);
-        }
+const BracketPair *token_store_brackets(TokenStore *store, size_t *count) {
+    if (store->bracket_tokens != store->count) {
+        token_store_match_brackets(store);
+    }
+    *count = store->bracket_count;
+    return store->brackets;
+}
 
-        lexer->capacity = new_capacity;
+const BracketPair *token_store_bracket(TokenStore *store, size_t index) {
+    size_t count;
+    const BracketPair *brackets = token_store_brackets(store, &count);
+    StoredToken token = stored_token(store, index);
+    if (!TOKEN_IS_BRACKET(token.type) || token.data >= count) {
+        return NULL;
     }
+    const BracketPair *pair = &brackets[token.data];
+    return pair->open == index || pair->close == index ? pair : NULL;
+}
 
-    lexer->tokens[lexer->token_count].type = type;
-    lexer->tokens[lexer->token_count].val = val;
-    lexer->tokens[lexer->token_count].need_free = malloced;
+static void push_token(Lexer *lexer, Token type, const char *start, uint32_t data) {
+    TokenStore *store = &lexer->tokens;
 
-    // setting the location
-    lexer->tokens[lexer->token_count].loc.line = lexer->line_number;
-    lexer->tokens[lexer->token_count].loc.col = lexer->cur_tok - lexer->line_start;
+    if (store->count == store->capacity) {
+        token_store_reserve(store, store->count + 1);
+    }
 
-    lexer->token_count++;
+    store->types[store->count] = (uint8_t)type;
+    store->offsets[store->count] = (uint32_t)(start - lexer->start_tok);
+    store->data[store->count] = data;
+    store->count++;
+}
+
+void add_token(Lexer *lexer, Token type, const char *start, size_t len) {
+    push_token(lexer, type, start, (uint32_t)len);
+}
+
+// Rebuilds the lexeme view of a stored token. Identifiers resolve to their
+// interned (lower-cased) name and keywords to their canonical text, so
+// "WHILE" reads as "while" exactly as when the lexeme was stored directly.
+TokenData lexer_token_view(const Lexer *lexer, size_t index) {
+    const TokenStore *store = &lexer->tokens;
+    StoredToken stored = stored_token(store, index);
+    TokenData token = {0};
+    token.type = stored.type;
+
+    const char *start = lexer->start_tok + stored.offset;
+    if (token.type == TOKEN_IDENTIFIER) {
+        token.sym = (SymbolId)stored.data;
+        token.val = symbol_name(token.sym);
+        token.len = symbol_length(token.sym);
+        return token;
+    }
+
+    if (TOKEN_HAS_NUMBER(token.type)) {
+        token.number = store->numbers[stored.data];
+        token.val = start;
+        token.len = (size_t)(scan_number_span(start) - start);
+        return token;
+    }
+
+    if (TOKEN_HAS_STRING(token.type, stored.data)) {
+        const StringValue *string = &store->strings[stored.data & ~TOKEN_STRING_SLOT];
+        token.val = string->text;
+        token.len = string->length;
+        return token;
+    }
+
+    if (TOKEN_IS_BRACKET(token.type)) {
+        token.val = start;
+        token.len = 1;
+        return token;
+    }
+
+    token.len = stored.data;
+    token.val = start;
+    if (token.type == TOKEN_EOF) {
+        token.val = NULL;
+    } else if (CHAR_CLASS[(unsigned char)*start] == CLASS_IDENT) {
+        // A string like "WHILE" starts with a letter too, hence the type check
+        const Keyword *keyword = lookup_keyword(start, token.len);
+        if (keyword && keyword->type == token.type) token.val = keyword->text;
+    }
+    return token;
+}
+
+size_t lexer_token_end(const Lexer *lexer, size_t index) {
+    StoredToken stored = stored_token(&lexer->tokens, index);
+    size_t offset = stored.offset;
+
+    // Decoded strings record their slot rather than their length, so their
+    // span is scanned again the way the lexer first scanned it
+    if (TOKEN_HAS_STRING(stored.type, stored.data)) {
+        const char *p = scan_string_body(lexer->start_tok + offset);
+        while (*p == '\\') {
+            p = scan_string_body(p + 2);
+        }
+        return (size_t)(p - lexer->start_tok);
+    }
+    if (stored.type == TOKEN_EOF) {
+        return offset;
+    }
+    return offset + lexer_token_view(lexer, index).len;
+}
+
+TokenData lexer_token(Lexer *lexer, size_t index) {
+    TokenData token = lexer_token_view(lexer, index);
+
+    size_t at = token_store_offset(&lexer->tokens, index);
+    unsigned char first = (unsigned char)lexer->start_tok[at];
+    if (token.type == TOKEN_CHAR_LIT) {
+        at += 2;
+    } else if (token.type == TOKEN_IDENTIFIER || token.type == TOKEN_STR_LIT || token.type == INVALID ||
+               (token.type != TOKEN_EOF && (CHAR_CLASS[first] == CLASS_IDENT || CHAR_CLASS[first] == CLASS_DIGIT))) {
+        at = lexer_token_end(lexer, index);
+    }
+    token.loc = lexer_location(lexer, at);
+    return token;
+}
+
+Location lexer_location(Lexer *lexer, size_t offset) {
+    if (lexer->lines.count == 0) {
+        line_index_build(&lexer->lines, lexer->start_tok);
+    }
+
+    size_t line = line_index_find(&lexer->lines, offset);
+    size_t col = offset - line_index_start(&lexer->lines, line);
+    if (line == 0) col += lexer->column_base;
+    return (Location){lexer->line_base + line + 1, col};
 }
 
 void handle_identifier(Lexer *lexer) {
     char *str_start = lexer->cur_tok;
-    lexer->cur_tok++;
-    
+    int has_upper = 0;
+
+    lexer->cur_tok = (char *)scan_ident_span(str_start, &has_upper);
+
+    // Non-ASCII letters are kept as they are; only the ASCII runs between
+    // them take part in case folding
+    while (lexer->unicode_identifiers && (unsigned char)*lexer->cur_tok >= 0x80) {
+        size_t letter = utf8_letter_length(lexer->cur_tok);
+        if (letter == 0) break;
+        int upper = 0;
+        lexer->cur_tok = (char *)scan_ident_span(lexer->cur_tok + letter, &upper);
+        has_upper |= upper;
+    }
+    size_t str_len = lexer->cur_tok - str_start;
 
-    while (*lexer->cur_tok != '\0' && (isalnum(*lexer->cur_tok) || *lexer->cur_tok == '_')) {
-        lexer->cur_tok++;
-    } 
-    int str_len = lexer->cur_tok - str_start;
-    Token keyword_token = handle_keyword(str_start, str_len);
-    
-    char *identifier = (char *)malloc(str_len + 1);
-    if (identifier == NULL) {
-        fprintf(stderr, "Fatal Error: Memory allocation failed for identifier\n");
-        exit(1);
+    const Keyword *keyword = lookup_keyword(str_start, str_len);
+    if (keyword) {
+        add_token(lexer, keyword->type, str_start, str_len);
+        return;
     }
 
-    strncpy(identifier, str_start, str_len);
-    identifier[str_len] = '\0';
-    str_to_lower(identifier);
+    // Identifiers are case-insensitive and interned in their folded form;
+    // an already lower-case lexeme skips the folding.
+    SymbolId sym = has_upper ? symbol_intern_lower(str_start, str_len)
+                             : symbol_intern(str_start, str_len);
+    push_token(lexer, TOKEN_IDENTIFIER, str_start, sym);
+}
 
-    if (keyword_token != TOKEN_IDENTIFIER) {
+// Powers of ten that are exact doubles
+static const double EXACT_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
 
-        add_token(lexer, keyword_token, identifier, 1);
-    } else {
-        add_token(lexer, TOKEN_IDENTIFIER, identifier, 1);
+// Decodes the digit run [p, end), with one '.' for a TOKEN_FLOAT. Returns
+// false when the value does not fit in an int64_t or a finite double.
+//
+// Integers of up to 18 digits cannot overflow, so only longer ones pay for
+// the check. A float whose digits fit in 15 decimal places and that has at
+// most 22 after the point is one exact integer divided by an exact power
+// of ten, which a single IEEE division rounds correctly; anything longer
+// goes through strtod.
+static bool decode_number(const char *p, const char *end, Token type, NumberValue *value) {
+    if (type == TOKEN_INTEGER) {
+        uint64_t n = 0;
+        if (end - p <= 18) {
+            for (; p < end; p++) {
+                n = n * 10 + (uint64_t)(*p - '0');
+            }
+        } else {
+            for (; p < end; p++) {
+                uint64_t digit = (uint64_t)(*p - '0');
+                if (n > ((uint64_t)INT64_MAX - digit) / 10) return false;
+                n = n * 10 + digit;
+            }
+        }
+        value->i = (int64_t)n;
+        return true;
+    }
+
+    uint64_t mantissa = 0;
+    size_t digits = 0;
+    size_t fraction = 0;
+    const char *dot = NULL;
+    for (const char *q = p; q < end; q++) {
+        if (*q == '.') {
+            dot = q;
+            continue;
+        }
+        if (digits < 15) mantissa = mantissa * 10 + (uint64_t)(*q - '0');
+        digits++;
+        if (dot) fraction++;
+    }
+    if (digits <= 15 && fraction <= 22) {
+        value->f = (double)mantissa / EXACT_POWERS_OF_TEN[fraction];
+        return true;
+    }
+
+    // strtod needs a terminator, and must not read on into e.g. "1.5e3"
+    char buf[64];
+    size_t len = (size_t)(end - p);
+    char *copy = len < sizeof(buf) ? buf : (char *)malloc(len + 1);
+    if (!copy) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for number literal\n");
+        exit(1);
     }
+    memcpy(copy, p, len);
+    copy[len] = '\0';
+    value->f = strtod(copy, NULL);
+    if (copy != buf) free(copy);
+    return !isinf(value->f);
 }
 
 void handle_number_token(Lexer *lexer) {
@@ -383,45 +1355,37 @@ void handle_number_token(Lexer *lexer) {
     int decimal_count = 0;
     int is_valid = 1; 
     
-    if (*str_start == '.') {
-        // Must be followed by a digit (e.g., .123)
-        if (!isdigit(*(str_start + 1))) {
-            return;
-        }
+    // Numbers start with a digit; a leading '.' is always TOKEN_DOT.
+    // Find the whole digit/dot run in one go, then validate its dots: the
+    // number ends at the point where a second decimal point would appear.
+    char *span_end = (char *)scan_number_span(str_start);
+    char *extra_dot = NULL;
+    char *dot = memchr(str_start, '.', span_end - str_start);
+
+    if (dot != NULL) {
         decimal_count = 1;
+        extra_dot = memchr(dot + 1, '.', span_end - (dot + 1));
     }
-    
- 
-    while (isdigit(*lexer->cur_tok) || (*lexer->cur_tok == '.' && *lexer->cur_tok != '\0')) { 
-        if (*lexer->cur_tok == '.') {
-            if (++decimal_count > 1) {
-                is_valid = 0; 
-                fprintf(stderr, "%zu: Error: Invalid number format — multiple decimal points\n", 
-                                 lexer->line_number);
-                break; 
-            }
+
+    if (extra_dot != NULL) {
+        is_valid = 0; 
+        if (!muted(lexer)) {
+            fprintf(stderr, "%zu: Error: Invalid number format — multiple decimal points\n", 
+                    locate(lexer, lexer->cur_tok).line);
         }
-        lexer->cur_tok++;
+        lexer->cur_tok = extra_dot;
+    } else {
+        lexer->cur_tok = span_end;
     }
 
     // Recovery Block: Also check for NULL terminator here!
     if (!is_valid) {
         // Consume the remaining garbage as part of the INVALID token's lexeme
-        while ((isalnum(*lexer->cur_tok) || *lexer->cur_tok == '.') && *lexer->cur_tok != '\0') { 
+        while ((IS_IDENT_CHAR(*lexer->cur_tok) && *lexer->cur_tok != '_') || *lexer->cur_tok == '.') {
             lexer->cur_tok++;
         }
     }
 
-    int str_len = lexer->cur_tok - str_start;
-    char *number_str = (char *)malloc(str_len + 1);
-    if (number_str == NULL) {
-        fprintf(stderr, "Fatal Error: Memory allocation failed for number token\n");
-        exit(1);
-    }
-    
-    strncpy(number_str, str_start, str_len);
-    number_str[str_len] = '\0';
-
     // Decide the token type based on the flag
     Token token_type;
     if (!is_valid) {
@@ -432,51 +1396,24 @@ void handle_number_token(Lexer *lexer) {
         token_type = TOKEN_INTEGER; // Integer number
     }
 
-    add_token(lexer, token_type, number_str, 1);
-}
-
-Token handle_keyword(const char *input_word, size_t word_length) {
-    
-    State current_state = S_START;
-    const StateNode* current_node = get_node(S_START);
-
-    for (size_t i = 0; i < word_length; i++) {
-        char c = tolower((unsigned char)input_word[i]);
-
-        if (c < 'a' || c > 'z') {
-            return TOKEN_IDENTIFIER; 
+    NumberValue value;
+    if (token_type != INVALID && !decode_number(str_start, lexer->cur_tok, token_type, &value)) {
+        if (!muted(lexer)) {
+            fprintf(stderr, "%zu: Error: Number literal out of range\n", locate(lexer, str_start).line);
         }
-
-        if (current_state == S_IDENT) {
-            continue; 
-        }
-
-        State next_state = S_IDENT; // Initialize
-
-        for (int j = 0; j < current_node->num_transitions; j++) {
-            char transition_char = current_node->transitions[j].input_char;
-
-            // Check for specific character match
-            if (transition_char == c) {
-                next_state = current_node->transitions[j].next_state;
-                break;
-            }
-
-
-            if (transition_char == DEFAULT_CHAR) {
-                next_state = current_node->transitions[j].next_state;
-            }
-        }
-        // Move to the next state
-        current_state = next_state; 
-        current_node = get_node(current_state);
+        token_type = INVALID;
     }
 
-    // Final check for an accepting state
-    if (current_node->output != TOKEN_NONE) {
-        return current_node->output;
+    if (token_type == INVALID) {
+        add_token(lexer, token_type, str_start, lexer->cur_tok - str_start);
+        return;
     }
-    return TOKEN_IDENTIFIER;
+    push_token(lexer, token_type, str_start, token_store_add_number(&lexer->tokens, value));
+}
+
+Token handle_keyword(const char *input_word, size_t word_length) {
+    const Keyword *keyword = lookup_keyword(input_word, word_length);
+    return keyword ? keyword->type : TOKEN_IDENTIFIER;
 }
 
 void str_to_lower(char *str) {
@@ -485,207 +1422,90 @@ void str_to_lower(char *str) {
     }
 }
 
-// Free the memory allocated for the lexer
+// Free the memory allocated for the lexer. Lexemes are views into the source,
+// the symbol table or the token store, so only the token store and the line
+// index are owned here.
 void free_lexer(Lexer *lexer) {
+    token_store_free(&lexer->tokens);
+    line_index_free(&lexer->lines);
+}
+
 
-    for (size_t i = 0; i < lexer->token_count; i++) {
-        if (lexer->tokens[i].need_free) {
-            free(lexer->tokens[i].val);
-        }
-    }
-    free(lexer->tokens);
-}
-
-
-const StateNode MACHINE_DEF[NUM_STATES] = {
-    [S_START] = {S_START, TOKEN_NONE, {
-        {'a', S_A}, {'o', S_O}, {'n', S_N}, {'s', S_S}, {'e', S_E}, 
-        {'c', S_C}, {'i', S_I}, {'w', S_W}, {'l', S_L}, {'m', S_M},
-        {'t', S_T}, {'f', S_F}, {'r', S_R}, {'d', S_D}, {'g', S_G},
-        {'b', S_B},
-        {DEFAULT_CHAR, S_IDENT} // Explicit Default Transition
-    }, 18}, 
-
-    [S_A] = {S_A, TOKEN_NONE, {{'n', S_AN}, {'s', S_AS}, {'l', S_AL}, {DEFAULT_CHAR, S_IDENT}}, 4},
-    [S_AN] = {S_AN, TOKEN_NONE, {{'d', S_AND}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_AND] = {S_AND, TOKEN_AND, {{DEFAULT_CHAR, S_IDENT}}, 1}, 
-    [S_AS] = {S_AS, TOKEN_NONE, {{'k', S_ASK}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_ASK] = {S_ASK, TOKEN_ASK, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_AL] = {S_AL, TOKEN_NONE, {{'s', S_ALS}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_ALS] = {S_ALS, TOKEN_NONE, {{'o', S_ALSO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_ALSO] = {S_ALSO, TOKEN_ALSO, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_B] = {S_B, TOKEN_NONE, {{'o', S_BO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_BO] = {S_BO, TOKEN_NONE, {{'o', S_BOO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_BOO] = {S_BOO, TOKEN_NONE, {{'l', S_BOOL}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_BOOL] = {S_BOOL, TOKEN_BOOL, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_C] = {S_C, TOKEN_NONE, {{'o', S_CO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_CO] = {S_CO, TOKEN_NONE, {{'n', S_CON}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_CON] = {S_CON, TOKEN_NONE, {{'t', S_CONT}, {'s', S_CONS}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_CONS] = {S_CONS, TOKEN_NONE, {{'t', S_CONST}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_CONST] = {S_CONST, TOKEN_CONST, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_CONT] = {S_CONT, TOKEN_NONE, {{'i', S_CONTI}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_CONTI] = {S_CONTI, TOKEN_NONE, {{'n', S_CONTIN}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_CONTIN] = {S_CONTIN, TOKEN_NONE, {{'u', S_CONTINU}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_CONTINU] = {S_CONTINU, TOKEN_NONE, {{'e', S_CONTINUE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_CONTINUE] = {S_CONTINUE, TOKEN_CONTINUE, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_D] = {S_D, TOKEN_NONE, {{'e', S_DE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_DE] = {S_DE, TOKEN_NONE, {{'c', S_DEC}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_DEC] = {S_DEC, TOKEN_NONE, {{'i', S_DECI}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_DECI] = {S_DECI, TOKEN_NONE, {{'m', S_DECIM}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_DECIM] = {S_DECIM, TOKEN_NONE, {{'a', S_DECIMA}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_DECIMA] = {S_DECIMA, TOKEN_NONE, {{'l', S_DECIMAL}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_DECIMAL] = {S_DECIMAL, TOKEN_DECIMAL, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_E] = {S_E, TOKEN_NONE, {{'n', S_EN}, {'l', S_EL}, {'x', S_EX}, {'a', S_EA}, {DEFAULT_CHAR, S_IDENT}}, 5},
-    [S_EN] = {S_EN, TOKEN_NONE, {{'d', S_END}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_END] = {S_END, TOKEN_END, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_EL] = {S_EL, TOKEN_NONE, {{'s', S_ELS}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_ELS] = {S_ELS, TOKEN_NONE, {{'e', S_ELSE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_ELSE] = {S_ELSE, TOKEN_ELSE, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_EX] = {S_EX, TOKEN_NONE, {{'i', S_EXI}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_EXI] = {S_EXI, TOKEN_NONE, {{'t', S_EXIT}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_EXIT] = {S_EXIT, TOKEN_EXIT, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_EA] = {S_EA, TOKEN_NONE, {{'c', S_EAC}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_EAC] = {S_EAC, TOKEN_NONE, {{'h', S_EACH}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_EACH] = {S_EACH, TOKEN_EACH, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_F] = {S_F, TOKEN_NONE, {{'a', S_FA}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_FA] = {S_FA, TOKEN_NONE, {{'l', S_FAL}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_FAL] = {S_FAL, TOKEN_NONE, {{'s', S_FALS}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_FALS] = {S_FALS, TOKEN_NONE, {{'e', S_FALSE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_FALSE] = {S_FALSE, TOKEN_FALSE, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_G] = {S_G, TOKEN_NONE, {{'r', S_GR}, {'o', S_GO}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_GO] = {S_GO, TOKEN_NONE, {{'t', S_GOT}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_GOT] = {S_GOT, TOKEN_NONE, {{'o', S_GOTO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_GOTO] = {S_GOTO, TOKEN_GOTO, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_GR] = {S_GR, TOKEN_NONE, {{'e', S_GRE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_GRE] = {S_GRE, TOKEN_NONE, {{'a', S_GREA}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_GREA] = {S_GREA, TOKEN_NONE, {{'t', S_GREAT}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_GREAT] = {S_GREAT, TOKEN_NONE, {{'e', S_GREATE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_GREATE] = {S_GREATE, TOKEN_NONE, {{'r', S_GREATER}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_GREATER] = {S_GREATER, TOKEN_GREATER, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_I] = {S_I, TOKEN_NONE, {{'f', S_IF}, {'m', S_IM}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_IF] = {S_IF, TOKEN_IF, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_IM] = {S_IM, TOKEN_NONE, {{'p', S_IMP}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_IMP] = {S_IMP, TOKEN_NONE, {{'o', S_IMPO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_IMPO] = {S_IMPO, TOKEN_NONE, {{'r', S_IMPOR}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_IMPOR] = {S_IMPOR, TOKEN_NONE, {{'t', S_IMPORT}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_IMPORT] = {S_IMPORT, TOKEN_IMPORT, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_L] = {S_L, TOKEN_NONE, {{'o', S_LO}, {'e', S_LE}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_LO] = {S_LO, TOKEN_NONE, {{'o', S_LOO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_LOO] = {S_LOO, TOKEN_NONE, {{'p', S_LOOP}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_LOOP] = {S_LOOP, TOKEN_LOOP, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_LE] = {S_LE, TOKEN_NONE, {{'t', S_LET}, {'s', S_LES}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_LET] = {S_LET, TOKEN_NONE, {{'t', S_LETT}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_LETT] = {S_LETT, TOKEN_NONE, {{'e', S_LETTE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_LETTE] = {S_LETTE, TOKEN_NONE, {{'r', S_LETTER}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_LETTER] = {S_LETTER, TOKEN_LETTER, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_LES] = {S_LES, TOKEN_NONE, {{'s', S_LESS}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_LESS] = {S_LESS, TOKEN_LESS, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_M] = {S_M, TOKEN_NONE, {{'a', S_MA}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_MA] = {S_MA, TOKEN_NONE, {{'i', S_MAI}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_MAI] = {S_MAI, TOKEN_NONE, {{'n', S_MAIN}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_MAIN] = {S_MAIN, TOKEN_MAIN, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_N] = {S_N, TOKEN_NONE, {{'o', S_NO}, {'u', S_NU}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_NO] = {S_NO, TOKEN_NONE, {{'t', S_NOT}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_NOT] = {S_NOT, TOKEN_NOT, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_NU] = {S_NU, TOKEN_NONE, {{'m', S_NUM}, {'l', S_NUL}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_NUL] = {S_NUL, TOKEN_NONE, {{'l', S_NULL}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_NULL] = {S_NULL, TOKEN_NULL, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_NUM] = {S_NUM, TOKEN_NONE, {{'b', S_NUMB}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_NUMB] = {S_NUMB, TOKEN_NONE, {{'e', S_NUMBE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_NUMBE] = {S_NUMBE, TOKEN_NONE, {{'r', S_NUMBER}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_NUMBER] = {S_NUMBER, TOKEN_NUMBER, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_O] = {S_O, TOKEN_NONE, {{'r', S_OR}, {'f', S_OF}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_OR] = {S_OR, TOKEN_OR, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_OF] = {S_OF, TOKEN_OF, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_R] = {S_R, TOKEN_NONE, {{'e', S_RE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_RE] = {S_RE, TOKEN_NONE, {{'p', S_REP}, {'t', S_RET}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_REP] = {S_REP, TOKEN_NONE, {{'e', S_REPE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_REPE] = {S_REPE, TOKEN_NONE, {{'a', S_REPEA}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_REPEA] = {S_REPEA, TOKEN_NONE, {{'t', S_REPEAT}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_REPEAT] = {S_REPEAT, TOKEN_REPEAT, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_RET] = {S_RET, TOKEN_NONE, {{'u', S_RETU}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_RETU] = {S_RETU, TOKEN_NONE, {{'r', S_RETUR}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_RETUR] = {S_RETUR, TOKEN_NONE, {{'n', S_RETURN}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_RETURN] = {S_RETURN, TOKEN_RETURN, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_S] = {S_S, TOKEN_NONE, {{'t', S_ST}, {'h', S_SH}, {'i', S_SI}, {DEFAULT_CHAR, S_IDENT}}, 4},
-    [S_SI] = {S_SI, TOKEN_NONE, {{'z', S_SIZ}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_SIZ] = {S_SIZ, TOKEN_NONE, {{'e', S_SIZE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_SIZE] = {S_SIZE, TOKEN_NONE, {{'o', S_SIZEO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_SIZEO] = {S_SIZEO, TOKEN_NONE, {{'f', S_SIZEOF}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_SIZEOF] = {S_SIZEOF, TOKEN_SIZEOF, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_ST] = {S_ST, TOKEN_NONE, {{'a', S_STA}, {'o', S_STO}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_STA] = {S_STA, TOKEN_NONE, {{'r', S_STAR}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_STAR] = {S_STAR, TOKEN_NONE, {{'t', S_START_KW}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_START_KW] = {S_START_KW, TOKEN_START, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_STO] = {S_STO, TOKEN_NONE, {{'p', S_STOP}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_STOP] = {S_STOP, TOKEN_STOP, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_SH] = {S_SH, TOKEN_NONE, {{'o', S_SHO}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_SHO] = {S_SHO, TOKEN_NONE, {{'w', S_SHOW}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_SHOW] = {S_SHOW, TOKEN_SHOW, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_T] = {S_T, TOKEN_NONE, {{'r', S_TR}, {'h', S_TH}, {DEFAULT_CHAR, S_IDENT}}, 4},
-    [S_TR] = {S_TR, TOKEN_NONE, {{'u', S_TRU}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_TRU] = {S_TRU, TOKEN_NONE, {{'e', S_TRUE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_TRUE] = {S_TRUE, TOKEN_TRUE, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_TH] = {S_TH, TOKEN_NONE, {{'e', S_THE}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_THE] = {S_THE, TOKEN_NONE, {{'n', S_THEN}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_THEN] = {S_THEN, TOKEN_THEN, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    [S_W] = {S_W, TOKEN_NONE, {{'h', S_WH}, {'o', S_WO}, {DEFAULT_CHAR, S_IDENT}}, 3},
-    [S_WH] = {S_WH, TOKEN_NONE, {{'i', S_WHI}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_WHI] = {S_WHI, TOKEN_NONE, {{'l', S_WHIL}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_WHIL] = {S_WHIL, TOKEN_NONE, {{'e', S_WHILE}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_WHILE] = {S_WHILE, TOKEN_WHILE, {{DEFAULT_CHAR, S_IDENT}}, 1},
-    [S_WO] = {S_WO, TOKEN_NONE, {{'r', S_WOR}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_WOR] = {S_WOR, TOKEN_NONE, {{'d', S_WORD}, {DEFAULT_CHAR, S_IDENT}}, 2},
-    [S_WORD] = {S_WORD, TOKEN_WORD, {{DEFAULT_CHAR, S_IDENT}}, 1},
-
-    // The Dead State definition
-    [S_IDENT] = {S_IDENT, TOKEN_NONE, {
-        {DEFAULT_CHAR, S_IDENT} 
-    }, 1}
+#define KEYWORD(first, second, last, text, type) \
+    [KEYWORD_HASH(first, second, last, sizeof(text) - 1)] = {text, type, sizeof(text) - 1}
+
+static const Keyword KEYWORDS[KEYWORD_TABLE_SIZE] = {
+    KEYWORD('a', 'n', 'd', "and", TOKEN_AND),
+    KEYWORD('a', 's', 'k', "ask", TOKEN_ASK),
+    KEYWORD('a', 'l', 'o', "also", TOKEN_ALSO),
+    KEYWORD('b', 'o', 'l', "bool", TOKEN_BOOL),
+    KEYWORD('c', 'o', 't', "const", TOKEN_CONST),
+    KEYWORD('c', 'o', 'e', "continue", TOKEN_CONTINUE),
+    KEYWORD('d', 'e', 'l', "decimal", TOKEN_DECIMAL),
+    KEYWORD('e', 'a', 'h', "each", TOKEN_EACH),
+    KEYWORD('e', 'l', 'e', "else", TOKEN_ELSE),
+    KEYWORD('e', 'n', 'd', "end", TOKEN_END),
+    KEYWORD('e', 'x', 't', "exit", TOKEN_EXIT),
+    KEYWORD('f', 'a', 'e', "false", TOKEN_FALSE),
+    KEYWORD('g', 'o', 'o', "goto", TOKEN_GOTO),
+    KEYWORD('g', 'r', 'r', "greater", TOKEN_GREATER),
+    KEYWORD('i', 'f', 'f', "if", TOKEN_IF),
+    KEYWORD('i', 'm', 't', "import", TOKEN_IMPORT),
+    KEYWORD('l', 'e', 's', "less", TOKEN_LESS),
+    KEYWORD('l', 'e', 'r', "letter", TOKEN_LETTER),
+    KEYWORD('l', 'o', 'p', "loop", TOKEN_LOOP),
+    KEYWORD('m', 'a', 'n', "main", TOKEN_MAIN),
+    KEYWORD('n', 'o', 't', "not", TOKEN_NOT),
+    KEYWORD('n', 'u', 'l', "null", TOKEN_NULL),
+    KEYWORD('n', 'u', 'r', "number", TOKEN_NUMBER),
+    KEYWORD('o', 'f', 'f', "of", TOKEN_OF),
+    KEYWORD('o', 'r', 'r', "or", TOKEN_OR),
+    KEYWORD('r', 'e', 't', "repeat", TOKEN_REPEAT),
+    KEYWORD('r', 'e', 'n', "return", TOKEN_RETURN),
+    KEYWORD('s', 'h', 'w', "show", TOKEN_SHOW),
+    KEYWORD('s', 'i', 'f', "sizeof", TOKEN_SIZEOF),
+    KEYWORD('s', 't', 't', "start", TOKEN_START),
+    KEYWORD('s', 't', 'p', "stop", TOKEN_STOP),
+    KEYWORD('t', 'h', 'n', "then", TOKEN_THEN),
+    KEYWORD('t', 'r', 'e', "true", TOKEN_TRUE),
+    KEYWORD('w', 'h', 'e', "while", TOKEN_WHILE),
+    KEYWORD('w', 'o', 'd', "word", TOKEN_WORD),
 };
 
-const StateNode* get_node(State s) {
-    if (s >= 0 && s < NUM_STATES) {
-        return &MACHINE_DEF[s];
-    }
-    return NULL; 
-}
+#undef KEYWORD
 
-void printLexerTokens(const Lexer *lexer) {
-    
-    printf("\n\n------------------------------------------\n");
-    printf("| %-20s | %-15s |\n", "Lexeme", "Token");
-    printf("------------------------------------------\n");
+// Folding with `| 0x20` only turns upper-case letters into lower-case ones;
+// no other byte can land on 'a'..'z', so this is an exact case-insensitive
+// compare against the all-letter keyword text.
+const Keyword *lookup_keyword(const char *word, size_t length) {
+    if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH) {
+        return NULL;
+    }
 
- 
-    for (size_t i = 0; i < lexer->token_count; i++) {
-        const TokenData *token = &lexer->tokens[i];
-        
-        // Get the printable name for the token type
-        const char *token_name = token_type_to_string(token->type);
+    unsigned char first = (unsigned char)word[0] | 0x20;
+    unsigned char second = (unsigned char)word[1] | 0x20;
+    unsigned char last = (unsigned char)word[length - 1] | 0x20;
+    const Keyword *keyword = &KEYWORDS[KEYWORD_HASH(first, second, last, length)];
 
-        // Print the lexeme and the token name
-        printf("| %-20s | %-15s |\n", token->val, token_name);
+    if (keyword->length != length) {
+        return NULL;
     }
-
-    printf("------------------------------------------\n");
+    for (size_t i = 0; i < length; i++) {
+        if (((unsigned char)word[i] | 0x20) != (unsigned char)keyword->text[i]) {
+            return NULL;
+        }
+    }
+    return keyword;
 }
 
+const char* get_keyword_static_text(Token type) {
+    for (size_t i = 0; i < KEYWORD_TABLE_SIZE; i++) {
+        if (KEYWORDS[i].text && KEYWORDS[i].type == type) {
+            return KEYWORDS[i].text;
+        }
+    }
+    return NULL;
+}
 
 const char *token_type_to_string(Token type) {
     switch (type) {
@@ -0,0 +1,280 @@
+#include "line_index.h"
+#include "scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_INDEX_INITIAL_CAPACITY 1024
+
+// Spliced indexes keep LINE_BLOCK_SIZE starts per block, and split a
+// block again once it outgrows LINE_BLOCK_CAPACITY
+#define LINE_BLOCK_SIZE 2048
+#define LINE_BLOCK_CAPACITY (2 * LINE_BLOCK_SIZE)
+
+static uint32_t* alloc_starts(size_t count) {
+    uint32_t* starts = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!starts) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for line index\n");
+        exit(1);
+    }
+    return starts;
+}
+
+static void free_blocks(LineIndex* index) {
+    for (size_t b = 0; b < index->block_count; b++) {
+        free(index->blocks[b].starts);
+    }
+    free(index->blocks);
+    index->blocks = NULL;
+    index->block_count = 0;
+    index->block_capacity = 0;
+}
+
+void line_index_build(LineIndex* index, const char* source) {
+    free_blocks(index);
+    if (index->capacity == 0) {
+        index->starts = (uint32_t*)malloc(LINE_INDEX_INITIAL_CAPACITY * sizeof(uint32_t));
+        if (!index->starts) {
+            fprintf(stderr, "Fatal Error: Memory allocation failed for line index\n");
+            exit(1);
+        }
+        index->capacity = LINE_INDEX_INITIAL_CAPACITY;
+    }
+
+    index->starts[0] = 0;
+    index->count = 1;
+    index->hint = 0;
+
+    const char* p = scan_line_starts(source, source, index->starts, &index->count, index->capacity);
+    while (*p != '\0') {
+        size_t new_capacity = index->capacity * 2;
+        uint32_t* temp = (uint32_t*)realloc(index->starts, new_capacity * sizeof(uint32_t));
+        if (!temp) {
+            fprintf(stderr, "Fatal Error: Memory allocation failed for line index\n");
+            exit(1);
+        }
+        index->starts = temp;
+        index->capacity = new_capacity;
+        p = scan_line_starts(source, p, index->starts, &index->count, index->capacity);
+    }
+}
+
+// Last block whose first line starts at or before `offset`; block 0 holds
+// line 0, which starts at 0
+static size_t block_at_offset(const LineIndex* index, size_t offset) {
+    size_t lo = 0;
+    size_t hi = index->block_count - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        const LineBlock* block = &index->blocks[mid];
+        if ((uint32_t)(block->base + block->starts[0]) <= offset) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// Last block whose first line is at or before `line`; the line past the
+// end falls in the last block
+static size_t block_at_line(const LineIndex* index, size_t line) {
+    size_t lo = 0;
+    size_t hi = index->block_count - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (index->blocks[mid].first <= line) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// Lines of `block` starting at or before `offset`
+static size_t block_starts_upto(const LineBlock* block, size_t offset) {
+    size_t lo = 0;
+    size_t hi = block->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((uint32_t)(block->base + block->starts[mid]) <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t line_index_find(LineIndex* index, size_t offset) {
+    if (index->blocks) {
+        const LineBlock* block = &index->blocks[block_at_offset(index, offset)];
+        return block->first + block_starts_upto(block, offset) - 1;
+    }
+
+    const uint32_t* starts = index->starts;
+    size_t last = index->count - 1;
+
+    // Tokens are usually resolved in source order: try the hinted line
+    // and the one after it first
+    size_t hint = index->hint;
+    if (starts[hint] <= offset) {
+        if (hint == last || offset < starts[hint + 1]) return hint;
+        if (hint + 1 == last || offset < starts[hint + 2]) return index->hint = hint + 1;
+    }
+
+    // Last line starting at or before offset; starts[0] is 0, so there is one
+    size_t lo = 0;
+    size_t hi = last;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (starts[mid] <= offset) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return index->hint = lo;
+}
+
+size_t line_index_start(const LineIndex* index, size_t line) {
+    if (!index->blocks) return index->starts[line];
+    const LineBlock* block = &index->blocks[block_at_line(index, line)];
+    return (uint32_t)(block->base + block->starts[line - block->first]);
+}
+
+// Index of the first line starting after `offset`
+static size_t first_start_after(const LineIndex* index, size_t offset) {
+    const LineBlock* block = &index->blocks[block_at_offset(index, offset)];
+    return block->first + block_starts_upto(block, offset);
+}
+
+static void reserve_blocks(LineIndex* index, size_t count) {
+    if (count <= index->block_capacity) return;
+    size_t new_capacity = index->block_capacity == 0 ? 16 : index->block_capacity * 2;
+    if (new_capacity < count) new_capacity = count;
+    LineBlock* blocks = (LineBlock*)realloc(index->blocks, new_capacity * sizeof(LineBlock));
+    if (!blocks) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for line index\n");
+        exit(1);
+    }
+    index->blocks = blocks;
+    index->block_capacity = new_capacity;
+}
+
+// Cuts `count` absolute starts into `pieces` blocks of about equal size
+static void cut_blocks(LineBlock* at, size_t pieces, const uint32_t* starts, size_t count, size_t first) {
+    size_t from = 0;
+    for (size_t p = 0; p < pieces; p++) {
+        size_t to = count * (p + 1) / pieces;
+        at[p].starts = alloc_starts(LINE_BLOCK_CAPACITY);
+        at[p].count = to - from;
+        at[p].first = first + from;
+        at[p].base = 0;
+        memcpy(at[p].starts, starts + from, (to - from) * sizeof(uint32_t));
+        from = to;
+    }
+}
+
+static size_t pieces_for(size_t count) {
+    return (count + LINE_BLOCK_SIZE - 1) / LINE_BLOCK_SIZE;
+}
+
+// A built index always holds line 0, so there is at least one block
+static void split_into_blocks(LineIndex* index) {
+    size_t pieces = pieces_for(index->count);
+    reserve_blocks(index, pieces);
+    cut_blocks(index->blocks, pieces, index->starts, index->count, 0);
+    index->block_count = pieces;
+
+    free(index->starts);
+    index->starts = NULL;
+    index->capacity = 0;
+}
+
+void line_index_splice(LineIndex* index, const char* source, size_t start,
+                       size_t old_end, size_t new_end) {
+    if (!index->blocks) split_into_blocks(index);
+
+    // A line starting at `start` follows a newline that was not edited
+    size_t first = first_start_after(index, start);
+    size_t last = first_start_after(index, old_end);
+
+    size_t added = 0;
+    for (const char* p = source + start; p < source + new_end; p++) {
+        if (*p == '\n') added++;
+    }
+
+    size_t from = block_at_line(index, first);
+    size_t to = block_at_line(index, last);
+    LineBlock* head = &index->blocks[from];
+    LineBlock* tail = &index->blocks[to];
+    size_t head_keep = first - head->first;
+    size_t tail_from = last - tail->first;
+    size_t tail_count = tail->count - tail_from;
+    size_t total = head_keep + added + tail_count;
+
+    // Offsets past the edit move by new_end - old_end, modulo 2^32
+    uint32_t shift = (uint32_t)(new_end - old_end);
+    size_t after; // First block past the rewritten ones
+    if (from == to && total > 0 && total <= LINE_BLOCK_CAPACITY) {
+        memmove(head->starts + head_keep + added, head->starts + tail_from, tail_count * sizeof(uint32_t));
+        for (size_t i = head_keep + added; i < total; i++) {
+            head->starts[i] += shift;
+        }
+        size_t at = head_keep;
+        for (const char* p = source + start; p < source + new_end; p++) {
+            if (*p == '\n') head->starts[at++] = (uint32_t)(p + 1 - source) - head->base;
+        }
+        head->count = total;
+        after = from + 1;
+    } else {
+        uint32_t* joined = alloc_starts(total);
+        for (size_t i = 0; i < head_keep; i++) {
+            joined[i] = head->base + head->starts[i];
+        }
+        size_t at = head_keep;
+        for (const char* p = source + start; p < source + new_end; p++) {
+            if (*p == '\n') joined[at++] = (uint32_t)(p + 1 - source);
+        }
+        for (size_t i = 0; i < tail_count; i++) {
+            joined[at + i] = tail->base + tail->starts[tail_from + i] + shift;
+        }
+
+        // Line 0 is never dropped, so at least block 0 remains
+        size_t pieces = pieces_for(total);
+        size_t replaced = to - from + 1;
+        size_t first_line = head->first;
+        for (size_t b = from; b <= to; b++) {
+            free(index->blocks[b].starts);
+        }
+        if (pieces > replaced) reserve_blocks(index, index->block_count - replaced + pieces);
+        memmove(index->blocks + from + pieces, index->blocks + to + 1,
+                (index->block_count - to - 1) * sizeof(LineBlock));
+        cut_blocks(index->blocks + from, pieces, joined, total, first_line);
+        index->block_count = index->block_count - replaced + pieces;
+        after = from + pieces;
+        free(joined);
+    }
+
+    for (size_t b = after; b < index->block_count; b++) {
+        index->blocks[b].base += shift;
+        index->blocks[b].first = index->blocks[b - 1].first + index->blocks[b - 1].count;
+    }
+    index->count = index->count - (last - first) + added;
+    index->hint = 0;
+}
+
+void line_index_clear(LineIndex* index) {
+    free_blocks(index);
+    index->count = 0;
+    index->hint = 0;
+}
+
+void line_index_free(LineIndex* index) {
+    free_blocks(index);
+    free(index->starts);
+    memset(index, 0, sizeof(*index));
+}
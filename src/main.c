@@ -4,7 +4,13 @@
 
 #include "lexer.h"
 #include "parse.h"
+#include "scan.h"
 #include "ast.h"
+#include "symtab.h"
+#include "source.h"
+#include "stats.h"
+#include "token_cache.h"
+#include "token_dump.h"
 
 // ============================================================================
 // Configuration & Enums
@@ -25,52 +31,17 @@ static int has_ec_extension(const char* filename) {
     return len >= 3 && strcmp(filename + len - 3, ".ec") == 0;
 }
 
-static char* read_file(const char* filename) {
-    FILE* f = fopen(filename, "rb");
-    if (!f) {
-        perror("Error opening file");
-        return NULL;
-    }
-
-    if (fseek(f, 0, SEEK_END) != 0) {
-        perror("Error checking file size");
-        fclose(f);
-        return NULL;
-    }
-
-    long size = ftell(f);
-    if (size < 0) {
-        perror("Error checking file size");
-        fclose(f);
-        return NULL;
-    }
-    rewind(f);
-
-    char* buf = (char*)malloc((size_t)size + 1);
-    if (!buf) {
-        fprintf(stderr, "Error: Memory allocation failed for file buffer\n");
-        fclose(f);
-        return NULL;
-    }
-
-    size_t n = fread(buf, 1, (size_t)size, f);
-    if (n < (size_t)size) {
-        fprintf(stderr, "Error: Failed to read entire file\n");
-        free(buf);
-        fclose(f);
-        return NULL;
-    }
-    fclose(f);
-
-    buf[n] = '\0';
-    return buf;
-}
-
 void print_usage(const char* prog_name) {
-    fprintf(stderr, "Usage: %s <input.ec> <output.txt> [options]\n", prog_name);
+    fprintf(stderr, "Usage: %s <input.ec|-> <output.txt> [options]\n", prog_name);
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  -l, --lexer    Run lexer only (prints tokens)\n");
     fprintf(stderr, "  -p, --parser   Run parser (prints AST) [Default]\n");
+    fprintf(stderr, "  -s, --switch-lexer  Use the reference switch-based scanner\n");
+    fprintf(stderr, "  -j, --jobs <n>      Lex large inputs on n threads\n");
+    fprintf(stderr, "  -u, --unicode-idents  Allow non-ASCII letters in identifiers\n");
+    fprintf(stderr, "  -c, --cache <dir>   Reuse token streams of unchanged sources from dir\n");
+    fprintf(stderr, "  -f, --format <fmt>  Token dump format for -l: table [Default], jsonl, binary\n");
+    fprintf(stderr, "      --stats         Print token and AST statistics to stderr\n");
 }
 
 // ============================================================================
@@ -86,6 +57,12 @@ int main(int argc, char* argv[]) {
     const char* input_path = argv[1];
     const char* output_path = argv[2];
     CompilerMode mode = MODE_PARSER; // Default behavior
+    ScannerKind scanner = SCANNER_TABLE;
+    unsigned jobs = 1;
+    int unicode_identifiers = 0;
+    const char* cache_dir = NULL;
+    TokenDumpFormat dump_format = TOKEN_DUMP_TABLE;
+    int show_stats = 0;
 
     // Parse optional arguments
     for (int i = 3; i < argc; i++) {
@@ -93,20 +70,44 @@ int main(int argc, char* argv[]) {
             mode = MODE_LEXER;
         } else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--parser") == 0) {
             mode = MODE_PARSER;
+        } else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--switch-lexer") == 0) {
+            scanner = SCANNER_SWITCH;
+        } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            jobs = n > 0 ? (unsigned)n : 1;
+        } else if (strcmp(argv[i], "-u") == 0 || strcmp(argv[i], "--unicode-idents") == 0) {
+            unicode_identifiers = 1;
+        } else if ((strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--cache") == 0) && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if ((strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--format") == 0) && i + 1 < argc) {
+            if (token_dump_format_parse(argv[++i], &dump_format) != 0) {
+                fprintf(stderr, "Warning: Unknown token dump format '%s', using table\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            show_stats = 1;
         } else {
             fprintf(stderr, "Warning: Unknown option '%s'\n", argv[i]);
         }
     }
 
-    // Validate Input Extension
-    if (!has_ec_extension(input_path)) {
+    // Read Source ("-" reads standard input)
+    SourceBuffer source_buf;
+    if (source_load(&source_buf, input_path) != 0) {
+        return 1;
+    }
+    char* source = source_buf.data;
+
+    // Validate Input Extension (stdin, pipes and devices have no meaningful name)
+    if (strcmp(input_path, "-") != 0 && source_buf.is_regular_file && !has_ec_extension(input_path)) {
         fprintf(stderr, "Error: Input file must have .ec extension\n");
+        source_free(&source_buf);
         return 1;
     }
 
-    // Read Source
-    char* source = read_file(input_path);
-    if (!source) {
+    // Token offsets are 32-bit
+    if (source_buf.length > TOKEN_STORE_MAX_SOURCE) {
+        fprintf(stderr, "Error: Input file is larger than 4 GB\n");
+        source_free(&source_buf);
         return 1;
     }
 
@@ -117,48 +118,96 @@ int main(int argc, char* argv[]) {
     
     lexer.start_tok  = source;
     lexer.cur_tok    = source;
-    lexer.line_start = source;
-    lexer.line_number = 1;
-    lexer.token_count = 0;
-    lexer.capacity = 0;
-    lexer.tokens = NULL; 
-
-    // Run Lexer (Phase 1)
-    // We run this regardless of mode, as Parser needs tokens.
-    if (lex(&lexer) != 0) {
-        fprintf(stderr, "Fatal Error: Lexing failed.\n");
-        free(source);
+    lexer.scanner = scanner;
+    lexer.threads = jobs;
+    lexer.unicode_identifiers = unicode_identifiers;
+
+    // Source text must be UTF-8. ASCII is checked a vector at a time, so
+    // the pass costs little next to lexing. A NUL ends the input for the
+    // lexer, and so it does here.
+    const char* malformed = scan_utf8_invalid(source);
+    if (*malformed != '\0') {
+        Location at = lexer_location(&lexer, (size_t)(malformed - source));
+        fprintf(stderr, "Error: Invalid UTF-8 at line %zu, col %zu\n", at.line, at.col);
+        source_free(&source_buf);
         free_lexer(&lexer);
         return 1;
     }
+    // The check stopped at the terminator, so it also measured the text
+    lexer.length = (size_t)(malformed - source);
+
+    // Run Lexer (Phase 1)
+    // Only the token dump needs the whole array; the parser pulls tokens
+    // from the lexer as it goes (lex_next), unless the lexing is spread
+    // over several threads, which needs the whole buffer up front, the
+    // tokens come from (or go to) the cache, or they are to be counted.
+    int lex_upfront = mode == MODE_LEXER || jobs > 1 || cache_dir != NULL || show_stats;
+    if (lex_upfront) {
+        TokenCacheKey cache_key;
+        int cached = 0;
+        if (cache_dir) {
+            cache_key = token_cache_key(&lexer, source_buf.length);
+            cached = token_cache_load(cache_dir, &cache_key, &lexer);
+        }
+
+        if (!cached) {
+            if (lex(&lexer) != 0) {
+                fprintf(stderr, "Fatal Error: Lexing failed.\n");
+                source_free(&source_buf);
+                free_lexer(&lexer);
+                return 1;
+            }
+            if (cache_dir) token_cache_store(cache_dir, &cache_key, &lexer);
+        }
+    }
+
+    // Printed last, after the diagnostics, but counted while the tokens are
+    // certainly all there
+    TokenStats token_stats;
+    AstStats ast_stats;
+    int have_ast_stats = 0;
+    if (show_stats) token_stats_collect(&lexer, &token_stats);
 
     // Redirect stdout to the output file
-    // This allows existing print functions (printLexerTokens, print_ast) to work unchanged.
+    // This allows existing print functions (print_ast) to work unchanged.
     if (freopen(output_path, "w", stdout) == NULL) {
         fprintf(stderr, "Error: Could not open output file '%s' for writing.\n", output_path);
-        free(source);
+        source_free(&source_buf);
         free_lexer(&lexer);
         return 1;
     }
 
     // Execute Mode Logic
     if (mode == MODE_LEXER) {
-        printf("=== Lexer Output ===\n");
-        printf("Source File: %s\n", input_path);
-        printf("Token Count: %zu\n\n", lexer.token_count);
-        printLexerTokens(&lexer);
+        // The machine-readable formats are the tokens alone
+        if (dump_format == TOKEN_DUMP_TABLE) {
+            printf("=== Lexer Output ===\n");
+            printf("Source File: %s\n", input_path);
+            printf("Token Count: %zu\n\n", lexer.tokens.count);
+        }
+
+        // The dump writes to the descriptor itself, behind what stdio holds
+        fflush(stdout);
+        if (token_dump(&lexer, fileno(stdout), dump_format) != 0) {
+            fprintf(stderr, "Error: Could not write output file '%s'.\n", output_path);
+            fclose(stdout);
+            source_free(&source_buf);
+            free_lexer(&lexer);
+            return 1;
+        }
     } 
     else {
         // MODE_PARSER
         printf("=== Parser Output (AST) ===\n");
         printf("Source File: %s\n\n", input_path);
 
-        Parser* parser = parser_create(lexer.tokens, lexer.token_count);
+        Parser* parser = lex_upfront ? parser_create(&lexer)
+                                     : parser_create_streaming(&lexer);
         if (!parser) {
             // Should theoretically not happen unless malloc fails
             fprintf(stderr, "Fatal Error: Failed to create parser.\n");
             fclose(stdout); // Close file handle
-            free(source);
+            source_free(&source_buf);
             free_lexer(&lexer);
             return 1;
         }
@@ -173,14 +222,25 @@ int main(int argc, char* argv[]) {
             printf("Check console (stderr) for syntax error details.\n");
         }
 
-        if (program) free_ast(program);
+        if (show_stats && program) {
+            ast_stats_collect(program, &ast_stats);
+            have_ast_stats = 1;
+        }
+
+        free_ast(&parser->nodes);
         parser_destroy(parser);
     }
 
+    if (show_stats) {
+        token_stats_print(stderr, &token_stats);
+        if (have_ast_stats) ast_stats_print(stderr, &ast_stats);
+    }
+
     // Cleanup
     fclose(stdout); // Close output file
     free_lexer(&lexer);
-    free(source);
+    symtab_free();
+    source_free(&source_buf);
 
     return 0;
 }
\ No newline at end of file
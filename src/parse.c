@@ -1,4 +1,5 @@
 #include "parse.h"
+#include "utf8.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -8,54 +9,87 @@
 // ============================================================================
 
 static const char* get_token_type_name(Token type);
+static char* token_strdup(Parser* parser, TokenData token);
+static void* node_alloc(Parser* parser, size_t size);
+static void push_pending(Parser* parser, ASTNode* node);
+static ASTNode** take_pending(Parser* parser, size_t base, size_t* count);
 
 // ============================================================================
 // Parser Initialization & Core
 // ============================================================================
 
-Parser* parser_create(TokenData* tokens, size_t count) {
-    Parser* parser = (Parser*)malloc(sizeof(Parser));
+Parser* parser_create(Lexer* lexer) {
+    Parser* parser = (Parser*)calloc(1, sizeof(Parser));
     if (!parser) {
         fprintf(stderr, "Fatal Error: Memory allocation failed for Parser\n");
         return NULL;
     }
-    parser->tokens = tokens;
+    parser->lexer = lexer;
     parser->current = 0;
-    parser->count = count;
     parser->has_error = 0;
+    arena_init(&parser->nodes, PARSER_NODE_CHUNK);
+    return parser;
+}
+
+Parser* parser_create_streaming(Lexer* lexer) {
+    Parser* parser = parser_create(lexer);
+    if (parser) parser->streaming = 1;
     return parser;
 }
 
 void parser_destroy(Parser* parser) {
-    if (parser) free(parser);
+    if (!parser) return;
+    arena_free(&parser->nodes);
+    free(parser->pending);
+    free(parser);
+}
+
+// Token at absolute position `pos`, materialising tokens up to it; callers
+// never reach further back than PARSER_WINDOW - 1 tokens, so the slot
+// still holds it. Past the end of a stored array the last token (EOF)
+// repeats, like lex_next does.
+static TokenData token_at(Parser* parser, size_t pos) {
+    while (parser->pulled <= pos) {
+        TokenData* slot = &parser->window[parser->pulled % PARSER_WINDOW];
+        if (parser->streaming) {
+            *slot = lex_next(parser->lexer);
+        } else if (parser->lexer->tokens.count == 0) {
+            *slot = (TokenData){.type = TOKEN_EOF};
+        } else {
+            size_t last = parser->lexer->tokens.count - 1;
+            *slot = lexer_token(parser->lexer, parser->pulled < last ? parser->pulled : last);
+        }
+        parser->pulled++;
+    }
+    return parser->window[pos % PARSER_WINDOW];
+}
+
+static Token type_at(Parser* parser, size_t pos) {
+    if (parser->streaming) return token_at(parser, pos).type;
+
+    const TokenStore* tokens = &parser->lexer->tokens;
+    if (pos >= tokens->count) return TOKEN_EOF;
+    return token_store_type(tokens, pos);
 }
 
 int is_at_end(Parser* parser) {
     if (!parser) return 1;
-    return parser->current >= parser->count || 
-           parser->tokens[parser->current].type == TOKEN_EOF; 
+    return type_at(parser, parser->current) == TOKEN_EOF;
 }
 
 TokenData peek(Parser* parser) {
-    if (!parser || parser->current >= parser->count) 
-        return (TokenData){TOKEN_EOF, NULL, {0, 0}, 0};
-    return parser->tokens[parser->current];
+    if (!parser) return (TokenData){.type = TOKEN_EOF};
+    return token_at(parser, parser->current);
 }
 
 TokenData peek_ahead(Parser* parser, int offset) {
-    if (!parser) return (TokenData){TOKEN_EOF, NULL, {0, 0}, 0};
-    
-    size_t pos = parser->current + offset;
-    if (pos >= parser->count) {
-        return (TokenData){TOKEN_EOF, NULL, {0, 0}, 0};
-    }
-    
-    return parser->tokens[pos];
+    if (!parser) return (TokenData){.type = TOKEN_EOF};
+    return token_at(parser, parser->current + offset);
 }
 
 TokenData previous(Parser* parser) {
-    if (!parser || parser->current == 0) return (TokenData){TOKEN_EOF, NULL, {0, 0}, 0};
-    return parser->tokens[parser->current - 1];
+    if (!parser || parser->current == 0) return (TokenData){.type = TOKEN_EOF};
+    return token_at(parser, parser->current - 1);
 }
 
 void read_token(Parser* parser) {
@@ -65,8 +99,8 @@ void read_token(Parser* parser) {
 }
 
 int check(Parser* parser, Token type) {
-    if (is_at_end(parser)) return 0;
-    return peek(parser).type == type;
+    Token current = type_at(parser, parser->current);
+    return current != TOKEN_EOF && current == type;
 }
 
 int expect(Parser* parser, Token type, const char* message) {
@@ -84,8 +118,9 @@ void error(Parser* parser, const char* message) {
     TokenData token = peek(parser);
     
     const char* type_name = get_token_type_name(token.type);
-    fprintf(stderr, "[line %zu] Error at '%s' (%s): %s\n", 
+    fprintf(stderr, "[line %zu] Error at '%.*s' (%s): %s\n", 
             token.loc.line, 
+            token.val ? (int)token.len : 3,
             token.val ? token.val : "EOF", 
             type_name,
             message);
@@ -134,61 +169,61 @@ ASTNode* parse_value(Parser* parser) {
     
     if (t.type == TOKEN_IDENTIFIER) {
         read_token(parser);
-        IdentifierNode* id = (IdentifierNode*)malloc(sizeof(IdentifierNode));
-        id->name = strdup(t.val);
-        return create_node_with_loc(NODE_IDENTIFIER, id, t);
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_IDENTIFIER, t);
+        IdentifierNode* id = &node->identifier;
+        id->name = t.sym;
+        return node;
     }
     
-    LiteralNode* lit = (LiteralNode*)malloc(sizeof(LiteralNode));
+    LiteralNode literal;
 
     switch (t.type) {
         case TOKEN_INTEGER:
-            lit->literal_type = LITERAL_NUMBER;
-            lit->value.int_value = atoi(t.val);
+            literal.literal_type = LITERAL_NUMBER;
+            literal.value.int_value = t.number.i;
             read_token(parser);
             break;
         case TOKEN_FLOAT:
-            lit->literal_type = LITERAL_DECIMAL;
-            lit->value.double_value = atof(t.val);
+            literal.literal_type = LITERAL_DECIMAL;
+            literal.value.double_value = t.number.f;
             read_token(parser);
             break;
         case TOKEN_STR_LIT:
-            lit->literal_type = LITERAL_STRING;
-            lit->value.string_value = strdup(t.val);
+            literal.literal_type = LITERAL_STRING;
+            literal.value.string_value = token_strdup(parser, t);
             read_token(parser);
             break;
         case TOKEN_CHAR_LIT:
-            lit->literal_type = LITERAL_CHAR;
-            lit->value.char_value = t.val[0];
+            literal.literal_type = LITERAL_CHAR;
+            utf8_decode(t.val, &literal.value.char_value);
             read_token(parser);
             break;
         case TOKEN_TRUE:
-            lit->literal_type = LITERAL_BOOL;
-            lit->value.bool_value = 1;
+            literal.literal_type = LITERAL_BOOL;
+            literal.value.bool_value = 1;
             read_token(parser);
             break;
         case TOKEN_FALSE:
-            lit->literal_type = LITERAL_BOOL;
-            lit->value.bool_value = 0;
+            literal.literal_type = LITERAL_BOOL;
+            literal.value.bool_value = 0;
             read_token(parser);
             break;
         case TOKEN_NULL:
-            lit->literal_type = LITERAL_NULL;
+            literal.literal_type = LITERAL_NULL;
             read_token(parser);
             break;
         default:
-            free(lit);
             return NULL; 
     }
     
-    return create_node_with_loc(NODE_LITERAL, lit, t);
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_LITERAL, t);
+    node->literal = literal;
+    return node;
 }
 
-ASTNode* parse_arg_list(Parser* parser) {
-    ArgListNode* list = (ArgListNode*)malloc(sizeof(ArgListNode));
-    list->count = 0;
-    list->capacity = 4;
-    list->args = (ASTNode**)malloc(sizeof(ASTNode*) * list->capacity);
+// The expressions of an argument list, as an array in the tree
+static ASTNode** parse_arguments(Parser* parser, size_t* count) {
+    size_t base = parser->pending_count;
 
     do {
         ASTNode* expr = parse_expr(parser);
@@ -196,16 +231,18 @@ ASTNode* parse_arg_list(Parser* parser) {
             error(parser, "Expected expression in argument list");
             break;
         }
-
-        if (list->count >= list->capacity) {
-            list->capacity *= 2;
-            list->args = (ASTNode**)realloc(list->args, sizeof(ASTNode*) * list->capacity);
-        }
-        list->args[list->count++] = expr;
+        push_pending(parser, expr);
 
     } while (check(parser, TOKEN_COMMA) && (read_token(parser), 1));
 
-    return create_node(NODE_ARG_LIST, list);
+    return take_pending(parser, base, count);
+}
+
+ASTNode* parse_arg_list(Parser* parser) {
+    ASTNode* node = create_node(&parser->nodes, NODE_ARG_LIST);
+    ArgListNode* list = &node->arg_list;
+    list->args = parse_arguments(parser, &list->count);
+    return node;
 }
 
 ASTNode* parse_fn_call(Parser* parser) {
@@ -213,28 +250,18 @@ ASTNode* parse_fn_call(Parser* parser) {
     read_token(parser); // ID
     read_token(parser); // '('
 
-    FuncCallNode* call = (FuncCallNode*)malloc(sizeof(FuncCallNode));
-    call->func_name = strdup(id_tok.val);
-    call->arguments = NULL;
-    call->count = 0;
-    call->capacity = 0;
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_FUNC_CALL, id_tok);
+    FuncCallNode* call = &node->call;
+    call->func_name = id_tok.sym;
 
     if (!check(parser, TOKEN_RPAREN)) {
-        ASTNode* argsNode = parse_arg_list(parser);
-        if (argsNode) {
-            ArgListNode* list = (ArgListNode*)argsNode->specific_node;
-            call->count = list->count;
-            call->capacity = list->capacity;
-            call->arguments = list->args;
-            free(list); 
-            free(argsNode); 
-        }
+        call->arguments = parse_arguments(parser, &call->count);
     }
 
     if (!expect(parser, TOKEN_RPAREN, "Expected ')' after function call arguments")) {
         return NULL;
     }
-    return create_node_with_loc(NODE_FUNC_CALL, call, id_tok);
+    return node;
 }
 
 ASTNode* parse_input_expr(Parser* parser) {
@@ -253,11 +280,12 @@ ASTNode* parse_input_expr(Parser* parser) {
     
     if (!expect(parser, TOKEN_RPAREN, "Expected ')' after type")) return NULL;
 
-    InputStmtNode* input = (InputStmtNode*)malloc(sizeof(InputStmtNode));
-    input->data_type = strdup(type_tok.val);
-    input->var_name = NULL; 
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_INPUT_STMT, ask_tok);
+    InputStmtNode* input = &node->input;
+    input->data_type = token_strdup(parser, type_tok);
+    input->var_name = SYMBOL_NONE; 
 
-    return create_node_with_loc(NODE_INPUT_STMT, input, ask_tok);
+    return node;
 }
 
 ASTNode* parse_sizeof(Parser* parser) {
@@ -271,10 +299,11 @@ ASTNode* parse_sizeof(Parser* parser) {
     }
     if (!expect(parser, TOKEN_RPAREN, "Expected ')'")) return NULL;
     
-    UnaryExpressionNode* unop = (UnaryExpressionNode*)malloc(sizeof(UnaryExpressionNode));
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_UNARY_EXPR, tok);
+    UnaryExpressionNode* unop = &node->unary;
     unop->operator = UNOP_POS; 
     unop->operand = val;
-    return create_node_with_loc(NODE_UNARY_EXPR, unop, tok);
+    return node;
 }
 
 ASTNode* parse_exp_rule(Parser* parser) {
@@ -309,10 +338,11 @@ ASTNode* parse_unary(Parser* parser) {
         read_token(parser);
         
         ASTNode* operand = parse_unary(parser);
-        UnaryExpressionNode* unop = (UnaryExpressionNode*)malloc(sizeof(UnaryExpressionNode));
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_UNARY_EXPR, op_tok);
+        UnaryExpressionNode* unop = &node->unary;
         unop->operator = op;
         unop->operand = operand;
-        return create_node_with_loc(NODE_UNARY_EXPR, unop, op_tok);
+        return node;
     }
     return parse_exp_rule(parser);
 }
@@ -325,11 +355,12 @@ ASTNode* parse_factor(Parser* parser) {
         read_token(parser);
         ASTNode* right = parse_factor(parser); 
         
-        BinaryExpressionNode* bin = (BinaryExpressionNode*)malloc(sizeof(BinaryExpressionNode));
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_BINARY_EXPR, op_tok);
+        BinaryExpressionNode* bin = &node->binary;
         bin->operator = OP_POW;
         bin->left = left;
         bin->right = right;
-        return create_node_with_loc(NODE_BINARY_EXPR, bin, op_tok);
+        return node;
     }
     return left;
 }
@@ -344,11 +375,12 @@ ASTNode* parse_term(Parser* parser) {
         read_token(parser);
         ASTNode* right = parse_factor(parser);
         
-        BinaryExpressionNode* bin = (BinaryExpressionNode*)malloc(sizeof(BinaryExpressionNode));
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_BINARY_EXPR, op_tok);
+        BinaryExpressionNode* bin = &node->binary;
         bin->operator = op;
         bin->left = left;
         bin->right = right;
-        left = create_node_with_loc(NODE_BINARY_EXPR, bin, op_tok);
+        left = node;
     }
     return left;
 }
@@ -362,11 +394,12 @@ ASTNode* parse_arith_expr(Parser* parser) {
         read_token(parser);
         ASTNode* right = parse_term(parser);
         
-        BinaryExpressionNode* bin = (BinaryExpressionNode*)malloc(sizeof(BinaryExpressionNode));
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_BINARY_EXPR, op_tok);
+        BinaryExpressionNode* bin = &node->binary;
         bin->operator = op;
         bin->left = left;
         bin->right = right;
-        left = create_node_with_loc(NODE_BINARY_EXPR, bin, op_tok);
+        left = node;
     }
     return left;
 }
@@ -380,11 +413,12 @@ ASTNode* parse_relational(Parser* parser) {
         read_token(parser);
         ASTNode* right = parse_arith_expr(parser);
         
-        BinaryExpressionNode* bin = (BinaryExpressionNode*)malloc(sizeof(BinaryExpressionNode));
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_BINARY_EXPR, op_tok);
+        BinaryExpressionNode* bin = &node->binary;
         bin->operator = op;
         bin->left = left;
         bin->right = right;
-        left = create_node_with_loc(NODE_BINARY_EXPR, bin, op_tok);
+        left = node;
     }
     return left;
 }
@@ -398,11 +432,12 @@ ASTNode* parse_equality(Parser* parser) {
         read_token(parser);
         ASTNode* right = parse_relational(parser);
         
-        BinaryExpressionNode* bin = (BinaryExpressionNode*)malloc(sizeof(BinaryExpressionNode));
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_BINARY_EXPR, op_tok);
+        BinaryExpressionNode* bin = &node->binary;
         bin->operator = op;
         bin->left = left;
         bin->right = right;
-        left = create_node_with_loc(NODE_BINARY_EXPR, bin, op_tok);
+        left = node;
     }
     return left;
 }
@@ -415,11 +450,12 @@ ASTNode* parse_bool_and(Parser* parser) {
         read_token(parser);
         ASTNode* right = parse_equality(parser);
         
-        BinaryExpressionNode* bin = (BinaryExpressionNode*)malloc(sizeof(BinaryExpressionNode));
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_BINARY_EXPR, op_tok);
+        BinaryExpressionNode* bin = &node->binary;
         bin->operator = OP_AND;
         bin->left = left;
         bin->right = right;
-        left = create_node_with_loc(NODE_BINARY_EXPR, bin, op_tok);
+        left = node;
     }
     return left;
 }
@@ -432,11 +468,12 @@ ASTNode* parse_bool_or(Parser* parser) {
         read_token(parser);
         ASTNode* right = parse_bool_and(parser);
         
-        BinaryExpressionNode* bin = (BinaryExpressionNode*)malloc(sizeof(BinaryExpressionNode));
+        ASTNode* node = create_node_with_loc(&parser->nodes, NODE_BINARY_EXPR, op_tok);
+        BinaryExpressionNode* bin = &node->binary;
         bin->operator = OP_OR;
         bin->left = left;
         bin->right = right;
-        left = create_node_with_loc(NODE_BINARY_EXPR, bin, op_tok);
+        left = node;
     }
     return left;
 }
@@ -454,40 +491,43 @@ ASTNode* parse_stmt_list(Parser* parser, Token delimiter);
 ASTNode* parse_block(Parser* parser);
 
 ASTNode* parse_param_list(Parser* parser) {
-    ParameterListNode* list = (ParameterListNode*)malloc(sizeof(ParameterListNode));
+    ASTNode* node = create_node(&parser->nodes, NODE_PARAM_LIST);
+    ParameterListNode* list = &node->param_list;
     list->count = 0;
-    list->capacity = 4;
-    list->parameters = (ParameterNode**)malloc(sizeof(ParameterNode*) * list->capacity);
+    list->capacity = AST_PARAM_LIST_CAPACITY;
+    list->parameters = (ParameterNode**)node_alloc(parser, sizeof(ParameterNode*) * list->capacity);
 
     do {
         if (!is_data_type(peek(parser).type)) {
             error(parser, "Expected parameter type");
             break;
         }
-        char* type = strdup(peek(parser).val);
+        char* type = token_strdup(parser, peek(parser));
         read_token(parser);
 
         if (!check(parser, TOKEN_IDENTIFIER)) {
             error(parser, "Expected parameter name");
-            free(type);
             break;
         }
-        char* name = strdup(peek(parser).val);
+        SymbolId name = peek(parser).sym;
         read_token(parser);
 
-        ParameterNode* param = (ParameterNode*)malloc(sizeof(ParameterNode));
+        ParameterNode* param = (ParameterNode*)node_alloc(parser, sizeof(ParameterNode));
         param->param_type = type;
         param->param_name = name;
 
+        // Parameter lists are short; the outgrown array stays in the arena
         if (list->count >= list->capacity) {
+            ParameterNode** grown = (ParameterNode**)node_alloc(parser, sizeof(ParameterNode*) * list->capacity * 2);
+            memcpy(grown, list->parameters, sizeof(ParameterNode*) * list->count);
+            list->parameters = grown;
             list->capacity *= 2;
-            list->parameters = (ParameterNode**)realloc(list->parameters, sizeof(ParameterNode*) * list->capacity);
         }
         list->parameters[list->count++] = param;
 
     } while (check(parser, TOKEN_COMMA) && (read_token(parser), 1));
 
-    return create_node(NODE_PARAM_LIST, list);
+    return node;
 }
 
 ASTNode* parse_func_decl(Parser* parser) {
@@ -514,13 +554,14 @@ ASTNode* parse_func_decl(Parser* parser) {
     
     ASTNode* body = parse_block(parser);
     
-    FuncDeclNode* func = (FuncDeclNode*)malloc(sizeof(FuncDeclNode));
-    func->return_type = strdup(type_tok.val);
-    func->func_name = strdup(id_tok.val);
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_FUNC_DECL, type_tok);
+    FuncDeclNode* func = &node->func_decl;
+    func->return_type = token_strdup(parser, type_tok);
+    func->func_name = id_tok.sym;
     func->params = params;
     func->body = body;
     
-    return create_node_with_loc(NODE_FUNC_DECL, func, type_tok);
+    return node;
 }
 
 ASTNode* parse_single_decl(Parser* parser, char* data_type, int is_const) {
@@ -536,51 +577,40 @@ ASTNode* parse_single_decl(Parser* parser, char* data_type, int is_const) {
         init = parse_expr(parser);
     }
     
-    VarDeclNode* decl = (VarDeclNode*)malloc(sizeof(VarDeclNode));
-    decl->var_name = strdup(id_tok.val);
-    decl->data_type = strdup(data_type);
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_VAR_DECL, id_tok);
+    VarDeclNode* decl = &node->var_decl;
+    decl->var_name = id_tok.sym;
+    decl->data_type = data_type;
     decl->is_const = is_const;
     decl->init_expr = init;
     
-    return create_node_with_loc(NODE_VAR_DECL, decl, id_tok);
+    return node;
 }
 
 ASTNode* parse_var_decl_wrapper(Parser* parser, int is_const) {
     TokenData type_tok = peek(parser);
-    char* data_type = strdup(type_tok.val);
+    char* data_type = token_strdup(parser, type_tok);
     read_token(parser);
     
-    StatementListNode* list = (StatementListNode*)malloc(sizeof(StatementListNode));
-    list->count = 0;
-    list->capacity = 4;
-    list->statements = (ASTNode**)malloc(sizeof(ASTNode*) * list->capacity);
+    size_t base = parser->pending_count;
     
     do {
         ASTNode* decl = parse_single_decl(parser, data_type, is_const);
         if (!decl) {
-            free(data_type);
-            free(list->statements);
-            free(list);
+            parser->pending_count = base;
             return NULL;
         }
-
-        if (list->count >= list->capacity) {
-            list->capacity *= 2;
-            list->statements = (ASTNode**)realloc(list->statements, sizeof(ASTNode*) * list->capacity);
-        }
-        list->statements[list->count++] = decl;
+        push_pending(parser, decl);
     } while (check(parser, TOKEN_COMMA) && (read_token(parser), 1));
     
-    free(data_type);
-    
-    if (list->count == 1) {
-        ASTNode* single = list->statements[0];
-        free(list->statements);
-        free(list);
-        return single;
+    if (parser->pending_count - base == 1) {
+        return parser->pending[--parser->pending_count];
     }
     
-    return create_node(NODE_STATEMENT_LIST, list);
+    ASTNode* node = create_node(&parser->nodes, NODE_STATEMENT_LIST);
+    StatementListNode* list = &node->list;
+    list->statements = take_pending(parser, base, &list->count);
+    return node;
 }
 
 ASTNode* parse_decl_stmt(Parser* parser) {
@@ -622,12 +652,13 @@ ASTNode* parse_ass_stmt(Parser* parser) {
     
     ASTNode* expr = parse_expr(parser);
     
-    AssignStmtNode* assign = (AssignStmtNode*)malloc(sizeof(AssignStmtNode));
-    assign->var_name = strdup(id_tok.val);
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_ASSIGN_STMT, id_tok);
+    AssignStmtNode* assign = &node->assign;
+    assign->var_name = id_tok.sym;
     assign->assign_type = op;
     assign->expr = expr;
     
-    return create_node_with_loc(NODE_ASSIGN_STMT, assign, id_tok);
+    return node;
 }
 
 ASTNode* parse_input_stmt(Parser* parser) {
@@ -639,8 +670,7 @@ ASTNode* parse_input_stmt(Parser* parser) {
     ASTNode* inputNode = parse_input_expr(parser);
     if (!inputNode) return NULL;
 
-    InputStmtNode* data = (InputStmtNode*)inputNode->specific_node;
-    data->var_name = strdup(id_tok.val);
+    inputNode->input.var_name = id_tok.sym;
     
     return inputNode;
 }
@@ -652,9 +682,10 @@ ASTNode* parse_output_stmt(Parser* parser) {
     ASTNode* expr = parse_expr(parser);
     if (!expect(parser, TOKEN_RPAREN, "Expected ')'")) return NULL;
     
-    OutputStmtNode* out = (OutputStmtNode*)malloc(sizeof(OutputStmtNode));
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_OUTPUT_STMT, tok);
+    OutputStmtNode* out = &node->output;
     out->expr = expr;
-    return create_node_with_loc(NODE_OUTPUT_STMT, out, tok);
+    return node;
 }
 
 ASTNode* parse_block(Parser* parser) {
@@ -668,15 +699,15 @@ ASTNode* parse_block(Parser* parser) {
     
     if (!expect(parser, TOKEN_RBRACE, "Expected '}'")) return NULL;
     
-    StatementListNode* blkData = list ? (StatementListNode*)list->specific_node : NULL;
-    if (!blkData) {
-        blkData = (StatementListNode*)malloc(sizeof(StatementListNode));
-        blkData->count=0; blkData->capacity=0; blkData->statements=NULL;
+    if (!list) {
+        return create_node_with_loc(&parser->nodes, NODE_BLOCK, tok);
     }
     
-    if (list) free(list); 
-    
-    return create_node_with_loc(NODE_BLOCK, blkData, tok);
+    // The statement list becomes the block
+    list->type = NODE_BLOCK;
+    list->line = tok.loc.line;
+    list->column = tok.loc.col;
+    return list;
 }
 
 ASTNode* parse_cond_stmt(Parser* parser) {
@@ -707,11 +738,12 @@ ASTNode* parse_cond_stmt(Parser* parser) {
         }
     }
     
-    CondStmtNode* node = (CondStmtNode*)malloc(sizeof(CondStmtNode));
-    node->condition = cond;
-    node->then_body = thenBody;
-    node->else_body = elseBody;
-    return create_node_with_loc(NODE_COND_STMT, node, tok);
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_COND_STMT, tok);
+    CondStmtNode* stmt = &node->cond;
+    stmt->condition = cond;
+    stmt->then_body = thenBody;
+    stmt->else_body = elseBody;
+    return node;
 }
 
 ASTNode* parse_iter_stmt(Parser* parser) {
@@ -736,12 +768,13 @@ ASTNode* parse_iter_stmt(Parser* parser) {
 
     ASTNode* body = parse_block(parser);
     
-    IterStmtNode* iter = (IterStmtNode*)malloc(sizeof(IterStmtNode));
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_ITER_STMT, tok);
+    IterStmtNode* iter = &node->iter;
     iter->init = init;
     iter->condition = cond;
     iter->increment = inc;
     iter->body = body;
-    return create_node_with_loc(NODE_ITER_STMT, iter, tok);
+    return node;
 }
 
 ASTNode* parse_return_stmt(Parser* parser) {
@@ -751,9 +784,10 @@ ASTNode* parse_return_stmt(Parser* parser) {
     if (!check(parser, TOKEN_SEMICOLON)) {
         expr = parse_expr(parser);
     }
-    ReturnStmtNode* ret = (ReturnStmtNode*)malloc(sizeof(ReturnStmtNode));
+    ASTNode* node = create_node_with_loc(&parser->nodes, NODE_RETURN_STMT, tok);
+    ReturnStmtNode* ret = &node->ret;
     ret->expr = expr;
-    return create_node_with_loc(NODE_RETURN_STMT, ret, tok);
+    return node;
 }
 
 ASTNode* parse_simple_stmt(Parser* parser) {
@@ -762,8 +796,8 @@ ASTNode* parse_simple_stmt(Parser* parser) {
     if (t == TOKEN_CONST || is_data_type(t)) return parse_decl_stmt(parser);
     if (t == TOKEN_SHOW) return parse_output_stmt(parser);
     if (t == TOKEN_RETURN) return parse_return_stmt(parser);
-    if (t == TOKEN_CONTINUE) { read_token(parser); return create_node(NODE_CONTINUE_STMT, NULL); }
-    if (t == TOKEN_STOP) { read_token(parser); return create_node(NODE_STOP_STMT, NULL); }
+    if (t == TOKEN_CONTINUE) { read_token(parser); return create_node(&parser->nodes, NODE_CONTINUE_STMT); }
+    if (t == TOKEN_STOP) { read_token(parser); return create_node(&parser->nodes, NODE_STOP_STMT); }
     
     if (t == TOKEN_IDENTIFIER) {
         TokenData next = peek_ahead(parser, 1);
@@ -808,16 +842,14 @@ ASTNode* parse_statement(Parser* parser) {
 }
 
 ASTNode* parse_stmt_list(Parser* parser, Token delimiter) {
-    StatementListNode* list = (StatementListNode*)malloc(sizeof(StatementListNode));
-    list->count = 0; list->capacity = 8;
-    list->statements = (ASTNode**)malloc(sizeof(ASTNode*) * list->capacity);
+    size_t base = parser->pending_count;
     
     while (!is_at_end(parser) && !check(parser, delimiter)) {
         size_t start_pos = parser->current; 
         
         ASTNode* stmt = parse_statement(parser);
         if (stmt) {
-            add_statement(list, stmt);
+            push_pending(parser, stmt);
         } else {
             if (parser->has_error) {
                 synchronize(parser);
@@ -828,7 +860,10 @@ ASTNode* parse_stmt_list(Parser* parser, Token delimiter) {
         }
     }
     
-    return create_node(NODE_STATEMENT_LIST, list);
+    ASTNode* node = create_node(&parser->nodes, NODE_STATEMENT_LIST);
+    StatementListNode* list = &node->list;
+    list->statements = take_pending(parser, base, &list->count);
+    return node;
 }
 
 ASTNode* parse_global_declaration(Parser* parser) {
@@ -860,15 +895,14 @@ ASTNode* parse_global_declaration(Parser* parser) {
 }
 
 ASTNode* parse_program(Parser* parser) {
-    ProgramNode* prog = (ProgramNode*)malloc(sizeof(ProgramNode));
-    prog->global_count = 0;
-    prog->global_capacity = 8;
-    prog->global_decls = (ASTNode**)malloc(sizeof(ASTNode*) * prog->global_capacity);
+    ASTNode* node = create_node(&parser->nodes, NODE_PROGRAM);
+    ProgramNode* prog = &node->program;
+    size_t base = parser->pending_count;
     
     while (!check(parser, TOKEN_START) && !is_at_end(parser)) {
         ASTNode* decl = parse_global_declaration(parser);
         if (decl) {
-            add_global_decl(prog, decl);
+            push_pending(parser, decl);
         } else {
             // FIX: If we have an error, we manually reset the error flag if we successfully sync.
             // We use a custom sync loop here because global sync points are different (semicolon, start).
@@ -898,13 +932,15 @@ ASTNode* parse_program(Parser* parser) {
         }
     }
     
+    prog->global_decls = take_pending(parser, base, &prog->global_count);
+
     expect(parser, TOKEN_START, "Expected 'start'");
 
     prog->stmt_list = parse_stmt_list(parser, TOKEN_END);
     
     expect(parser, TOKEN_END, "Expected 'end'");
     
-    return create_node(NODE_PROGRAM, prog);
+    return node;
 }
 
 // ============================================================================
@@ -999,6 +1035,54 @@ int map_unary_operator(Token token) {
     }
 }
 
+// ============================================================================
+// Internal Helpers: Lexeme Access
+// ============================================================================
+
+// Token lexemes are (pointer, length) views into the source buffer, so any
+// text the AST keeps has to be copied out with an explicit terminator.
+static char* token_strdup(Parser* parser, TokenData token) {
+    char* copy = (char*)node_alloc(parser, token.len + 1);
+    if (token.len) memcpy(copy, token.val, token.len);
+    copy[token.len] = '\0';
+    return copy;
+}
+
+// ============================================================================
+// Internal Helpers: Tree Memory
+// ============================================================================
+
+static void* node_alloc(Parser* parser, size_t size) {
+    return arena_alloc(&parser->nodes, size);
+}
+
+static void push_pending(Parser* parser, ASTNode* node) {
+    if (parser->pending_count == parser->pending_capacity) {
+        size_t new_capacity = parser->pending_capacity == 0 ? 64 : parser->pending_capacity * 2;
+        ASTNode** pending = (ASTNode**)realloc(parser->pending, new_capacity * sizeof(ASTNode*));
+        if (!pending) {
+            fprintf(stderr, "Fatal Error: Memory reallocation failed for pending nodes\n");
+            exit(1);
+        }
+        parser->pending = pending;
+        parser->pending_capacity = new_capacity;
+    }
+    parser->pending[parser->pending_count++] = node;
+}
+
+// Moves the nodes pushed since `base` into the tree as one array, which is
+// NULL when there are none.
+static ASTNode** take_pending(Parser* parser, size_t base, size_t* count) {
+    *count = parser->pending_count - base;
+    ASTNode** nodes = NULL;
+    if (*count > 0) {
+        nodes = (ASTNode**)node_alloc(parser, *count * sizeof(ASTNode*));
+        memcpy(nodes, parser->pending + base, *count * sizeof(ASTNode*));
+    }
+    parser->pending_count = base;
+    return nodes;
+}
+
 // ============================================================================
 // Internal Helper: Token Name Lookup
 // ============================================================================
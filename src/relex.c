@@ -0,0 +1,176 @@
+#include "lexer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Incremental Relexing
+// ============================================================================
+//
+// Between tokens the lexer's only state is its position, so scanning can
+// resume at any byte where a token's scan began, and two scans that meet
+// at such a byte agree from there on. After an edit, scanning resumes at
+// the last token that starts before the edited bytes (its scan may have
+// looked into them), and stops as soon as a new token begins where an old
+// token began after the edit, shifted by the change in length. The tokens
+// in between are replaced and those after it keep their type and data;
+// only their offsets move. New number and decoded string tokens take over
+// the value slots of the ones they replace. Slots nothing took over, and
+// the text of replaced strings, are counted as dead and dropped once they
+// outweigh the live ones, so an editing session does not grow the side
+// tables without bound.
+//
+// An edit costs the scan from the resume point to where the tokens line
+// up, which is short unless the edit changes how a long stretch lexes
+// (opening a string, say), plus rewriting the blocks the replaced tokens
+// sit in and one addition per later block (token_store_splice()); the
+// line index is spliced the same way. The first edit splits the store and
+// the index into blocks, a pass over each. Finding the resume point is a
+// binary search, and the bracket table is only marked stale.
+
+// Dead values are left alone below these amounts: compacting is a pass
+// over every token, worth paying only for a sizeable share of waste
+#define RELEX_COMPACT_MIN_SLOTS 4096
+#define RELEX_COMPACT_MIN_TEXT (64 * 1024)
+
+static int values_need_compaction(const TokenStore *store) {
+    return (store->dead_numbers >= RELEX_COMPACT_MIN_SLOTS && store->dead_numbers * 2 > store->number_count) ||
+           (store->dead_strings >= RELEX_COMPACT_MIN_SLOTS && store->dead_strings * 2 > store->string_count) ||
+           (store->dead_text >= RELEX_COMPACT_MIN_TEXT && store->dead_text * 2 > store->string_bytes);
+}
+
+// Whether a token's offset is also where its scan began. String and
+// character literals point past their opening quote, and INVALID covers
+// tokens of both kinds.
+static int scan_starts_at_offset(Token type) {
+    return type != TOKEN_STR_LIT && type != TOKEN_CHAR_LIT && type != INVALID;
+}
+
+static int has_string(const TokenStore *store, size_t index) {
+    return TOKEN_HAS_STRING(token_store_type(store, index), token_store_data(store, index));
+}
+
+// Number of tokens starting before `offset`
+static size_t tokens_before(const TokenStore *store, size_t offset) {
+    size_t lo = 0;
+    size_t hi = store->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (token_store_offset(store, mid) < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+TokenSplice lexer_relex(Lexer *lexer, char *source, const TextEdit *edit) {
+    TokenStore *store = &lexer->tokens;
+    uint32_t shift = (uint32_t)(edit->new_end - edit->old_end); // Modulo 2^32
+
+    // Resume where the last token before the edit began
+    size_t first = tokens_before(store, edit->start);
+    while (first > 0 && !scan_starts_at_offset(token_store_type(store, first - 1))) {
+        first--;
+    }
+    size_t resume = 0;
+    if (first > 0) {
+        first--;
+        resume = token_store_offset(store, first);
+    }
+
+    lexer->start_tok = source;
+    lexer->cur_tok = source + resume;
+    if (lexer->length > 0) {
+        lexer->length = lexer->length - edit->old_end + edit->new_end;
+    }
+    if (lexer->lines.count > 0) {
+        line_index_splice(&lexer->lines, source, edit->start, edit->old_end, edit->new_end);
+    }
+
+    // Old tokens from `next` on are candidates to line up with
+    size_t next = tokens_before(store, edit->old_end);
+
+    // New tokens go to a separate store, then replace the old ones
+    TokenStore old = *store;
+    memset(store, 0, sizeof(*store));
+
+    for (;;) {
+        int eof = lex_step(lexer);
+        size_t start = (size_t)(lexer->token_start - source);
+
+        while (next < old.count && (size_t)(uint32_t)(token_store_offset(&old, next) + shift) < start) {
+            next++;
+        }
+        if (next < old.count && (uint32_t)(token_store_offset(&old, next) + shift) == start &&
+            scan_starts_at_offset(token_store_type(&old, next))) {
+            token_store_pop(store); // The old stream from `next` on is still valid
+            break;
+        }
+        if (eof) {
+            next = old.count;
+            break;
+        }
+    }
+
+    TokenStore fresh = *store;
+    *store = old;
+
+    TokenSplice splice = {first, next - first, fresh.count};
+
+    // New values take over the slots of the replaced tokens' values, in
+    // order; only values beyond those get new entries
+    size_t number_from = first;
+    size_t string_from = first;
+    for (size_t i = 0; i < fresh.count; i++) {
+        if (TOKEN_HAS_STRING(fresh.types[i], fresh.data[i])) {
+            const StringValue *string = &fresh.strings[fresh.data[i] & ~TOKEN_STRING_SLOT];
+            while (string_from < next && !has_string(store, string_from)) {
+                string_from++;
+            }
+            if (string_from < next) {
+                fresh.data[i] = token_store_data(store, string_from++);
+                token_store_replace_string(store, fresh.data[i] & ~TOKEN_STRING_SLOT, string->text, string->length);
+            } else {
+                fresh.data[i] = TOKEN_STRING_SLOT | token_store_add_string(store, string->text, string->length);
+            }
+            continue;
+        }
+        if (!TOKEN_HAS_NUMBER(fresh.types[i])) continue;
+        NumberValue value = fresh.numbers[fresh.data[i]];
+        while (number_from < next && !TOKEN_HAS_NUMBER(token_store_type(store, number_from))) {
+            number_from++;
+        }
+        if (number_from < next) {
+            fresh.data[i] = token_store_data(store, number_from++);
+            store->numbers[fresh.data[i]] = value;
+        } else {
+            fresh.data[i] = token_store_add_number(store, value);
+        }
+    }
+
+    // Values of replaced tokens that nothing took over
+    for (; number_from < next; number_from++) {
+        if (TOKEN_HAS_NUMBER(token_store_type(store, number_from))) store->dead_numbers++;
+    }
+    for (; string_from < next; string_from++) {
+        if (has_string(store, string_from)) {
+            store->dead_strings++;
+            store->dead_text += store->strings[token_store_data(store, string_from) & ~TOKEN_STRING_SLOT].length + 1;
+        }
+    }
+
+    token_store_splice(store, first, next, &fresh, shift);
+
+    // Pairs are indexed by token; the table is matched again if it is asked
+    // for, rather than by every edit
+    store->bracket_tokens = TOKEN_BRACKETS_STALE;
+
+    if (values_need_compaction(store)) {
+        token_store_compact_values(store);
+    }
+
+    token_store_free(&fresh);
+    return splice;
+}
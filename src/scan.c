@@ -0,0 +1,312 @@
+#include "scan.h"
+#include "utf8.h"
+
+#include <stdint.h>
+
+// ============================================================================
+// Vector Width Selection
+// ============================================================================
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#define SCAN_WIDTH 32
+typedef __m256i ScanVector;
+#define VEC_LOAD(p)    _mm256_load_si256((const __m256i *)(p))
+#define VEC_SPLAT(c)   _mm256_set1_epi8((char)(c))
+#define VEC_EQ(a, b)   _mm256_cmpeq_epi8((a), (b))
+#define VEC_OR(a, b)   _mm256_or_si256((a), (b))
+#define VEC_AND(a, b)  _mm256_and_si256((a), (b))
+#define VEC_GT(a, b)   _mm256_cmpgt_epi8((a), (b))
+#define VEC_MASK(v)    ((uint32_t)_mm256_movemask_epi8(v))
+#define FULL_MASK      0xFFFFFFFFu
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+#define SCAN_WIDTH 16
+typedef __m128i ScanVector;
+#define VEC_LOAD(p)    _mm_load_si128((const __m128i *)(p))
+#define VEC_SPLAT(c)   _mm_set1_epi8((char)(c))
+#define VEC_EQ(a, b)   _mm_cmpeq_epi8((a), (b))
+#define VEC_OR(a, b)   _mm_or_si128((a), (b))
+#define VEC_AND(a, b)  _mm_and_si128((a), (b))
+#define VEC_GT(a, b)   _mm_cmpgt_epi8((a), (b))
+#define VEC_MASK(v)    ((uint32_t)_mm_movemask_epi8(v))
+#define FULL_MASK      0xFFFFu
+
+#endif
+
+#ifdef SCAN_WIDTH
+
+// Bit i of every mask below stands for byte block[i]. The first block is
+// loaded from the aligned address at or below p and its masks are shifted
+// so that bit 0 is p itself; the vacated high bits read as "keep going",
+// which is right because those bytes belong to the next block.
+#define ALIGN_DOWN(p) ((const char *)((uintptr_t)(p) & ~(uintptr_t)(SCAN_WIDTH - 1)))
+
+// Signed byte compares: bytes >= 0x80 are negative and fall outside every
+// ASCII range tested here.
+#define VEC_IN_RANGE(v, lo, hi) VEC_AND(VEC_GT((v), VEC_SPLAT((lo) - 1)), VEC_GT(VEC_SPLAT((hi) + 1), (v)))
+
+static inline unsigned first_bit(uint32_t mask) {
+    return (unsigned)__builtin_ctz(mask);
+}
+
+static inline uint32_t blank_mask(ScanVector v) {
+    ScanVector blank = VEC_OR(VEC_OR(VEC_EQ(v, VEC_SPLAT(' ')), VEC_EQ(v, VEC_SPLAT('\t'))),
+                              VEC_OR(VEC_EQ(v, VEC_SPLAT('\r')), VEC_EQ(v, VEC_SPLAT('\n'))));
+    return VEC_MASK(blank);
+}
+
+const char *scan_blank_run(const char *p) {
+    const char *block = ALIGN_DOWN(p);
+    uint32_t stop = (~blank_mask(VEC_LOAD(block)) & FULL_MASK) >> (unsigned)(p - block);
+    if (stop) {
+        return p + first_bit(stop);
+    }
+
+    for (;;) {
+        block += SCAN_WIDTH;
+        stop = ~blank_mask(VEC_LOAD(block)) & FULL_MASK;
+        if (stop) {
+            return block + first_bit(stop);
+        }
+    }
+}
+
+const char *scan_to_newline(const char *p) {
+    const ScanVector nl = VEC_SPLAT('\n');
+    const ScanVector zero = VEC_SPLAT(0);
+
+    const char *block = ALIGN_DOWN(p);
+    ScanVector v = VEC_LOAD(block);
+    uint32_t stop = VEC_MASK(VEC_OR(VEC_EQ(v, nl), VEC_EQ(v, zero))) >> (unsigned)(p - block);
+    if (stop) {
+        return p + first_bit(stop);
+    }
+
+    for (;;) {
+        block += SCAN_WIDTH;
+        v = VEC_LOAD(block);
+        stop = VEC_MASK(VEC_OR(VEC_EQ(v, nl), VEC_EQ(v, zero)));
+        if (stop) {
+            return block + first_bit(stop);
+        }
+    }
+}
+
+static inline uint32_t string_stop_mask(ScanVector v) {
+    ScanVector stop = VEC_OR(VEC_OR(VEC_EQ(v, VEC_SPLAT('"')), VEC_EQ(v, VEC_SPLAT('\\'))),
+                             VEC_EQ(v, VEC_SPLAT(0)));
+    return VEC_MASK(stop);
+}
+
+const char *scan_string_body(const char *p) {
+    const char *block = ALIGN_DOWN(p);
+    uint32_t stop = string_stop_mask(VEC_LOAD(block)) >> (unsigned)(p - block);
+    if (stop) {
+        return p + first_bit(stop);
+    }
+
+    for (;;) {
+        block += SCAN_WIDTH;
+        stop = string_stop_mask(VEC_LOAD(block));
+        if (stop) {
+            return block + first_bit(stop);
+        }
+    }
+}
+
+const char *scan_ident_span(const char *p, int *has_upper) {
+    const ScanVector underscore = VEC_SPLAT('_');
+    const ScanVector case_bit = VEC_SPLAT(0x20);
+
+    const char *block = ALIGN_DOWN(p);
+    unsigned skip = (unsigned)(p - block);
+    const char *base = p;
+    uint32_t upper_seen = 0;
+
+    for (;;) {
+        ScanVector v = VEC_LOAD(block);
+        ScanVector upper = VEC_IN_RANGE(v, 'A', 'Z');
+        ScanVector letter = VEC_IN_RANGE(VEC_OR(v, case_bit), 'a', 'z');
+        ScanVector ident = VEC_OR(VEC_OR(letter, VEC_IN_RANGE(v, '0', '9')), VEC_EQ(v, underscore));
+        uint32_t stop = (~VEC_MASK(ident) & FULL_MASK) >> skip;
+        uint32_t upper_mask = VEC_MASK(upper) >> skip;
+
+        if (stop) {
+            unsigned idx = first_bit(stop);
+            upper_seen |= upper_mask & ((1u << idx) - 1);
+            *has_upper = upper_seen != 0;
+            return base + idx;
+        }
+        upper_seen |= upper_mask;
+
+        block += SCAN_WIDTH;
+        base = block;
+        skip = 0;
+    }
+}
+
+const char *scan_number_span(const char *p) {
+    const ScanVector dot = VEC_SPLAT('.');
+
+    const char *block = ALIGN_DOWN(p);
+    ScanVector v = VEC_LOAD(block);
+    uint32_t stop = (~VEC_MASK(VEC_OR(VEC_IN_RANGE(v, '0', '9'), VEC_EQ(v, dot))) & FULL_MASK)
+                    >> (unsigned)(p - block);
+    if (stop) {
+        return p + first_bit(stop);
+    }
+
+    for (;;) {
+        block += SCAN_WIDTH;
+        v = VEC_LOAD(block);
+        stop = ~VEC_MASK(VEC_OR(VEC_IN_RANGE(v, '0', '9'), VEC_EQ(v, dot))) & FULL_MASK;
+        if (stop) {
+            return block + first_bit(stop);
+        }
+    }
+}
+
+// One block per step, so there must be room for a whole block of line
+// starts before each one.
+const char *scan_line_starts(const char *origin, const char *p, uint32_t *starts,
+                             size_t *count, size_t capacity) {
+    const ScanVector nl = VEC_SPLAT('\n');
+    const ScanVector zero = VEC_SPLAT(0);
+
+    const char *block = ALIGN_DOWN(p);
+    unsigned skip = (unsigned)(p - block);
+    const char *base = p;
+    size_t n = *count;
+
+    while (capacity - n >= SCAN_WIDTH) {
+        ScanVector v = VEC_LOAD(block);
+        uint32_t nl_mask = VEC_MASK(VEC_EQ(v, nl)) >> skip;
+        uint32_t stop = VEC_MASK(VEC_EQ(v, zero)) >> skip;
+        if (stop) {
+            nl_mask &= (1u << first_bit(stop)) - 1;
+        }
+
+        uint32_t next_line = (uint32_t)(base - origin) + 1;
+        while (nl_mask) {
+            starts[n++] = next_line + first_bit(nl_mask);
+            nl_mask &= nl_mask - 1;
+        }
+        if (stop) {
+            *count = n;
+            return base + first_bit(stop);
+        }
+
+        block += SCAN_WIDTH;
+        base = block;
+        skip = 0;
+    }
+    *count = n;
+    return base;
+}
+
+// The sign bit of every byte is the movemask itself, so spotting a non-ASCII
+// byte costs one instruction on top of the NUL compare. Multi-byte sequences
+// are checked one by one, and the block scan resumes after the last of a run.
+static inline uint32_t ascii_stop_mask(ScanVector v) {
+    return VEC_MASK(v) | VEC_MASK(VEC_EQ(v, VEC_SPLAT(0)));
+}
+
+const char *scan_utf8_invalid(const char *p) {
+    for (;;) {
+        const char *block = ALIGN_DOWN(p);
+        uint32_t stop = ascii_stop_mask(VEC_LOAD(block)) >> (unsigned)(p - block);
+        if (stop) {
+            p += first_bit(stop);
+        } else {
+            do {
+                block += SCAN_WIDTH;
+                stop = ascii_stop_mask(VEC_LOAD(block));
+            } while (!stop);
+            p = block + first_bit(stop);
+        }
+
+        while ((unsigned char)*p >= 0x80) {
+            uint32_t code_point;
+            size_t length = utf8_decode(p, &code_point);
+            if (length == 0) return p;
+            p += length;
+        }
+        if (*p == '\0') return p;
+    }
+}
+
+#else // Scalar fallback
+
+const char *scan_blank_run(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    return p;
+}
+
+const char *scan_to_newline(const char *p) {
+    while (*p != '\n' && *p != '\0') {
+        p++;
+    }
+    return p;
+}
+
+const char *scan_string_body(const char *p) {
+    while (*p != '"' && *p != '\\' && *p != '\0') {
+        p++;
+    }
+    return p;
+}
+
+const char *scan_ident_span(const char *p, int *has_upper) {
+    int upper = 0;
+    for (;; p++) {
+        unsigned char c = (unsigned char)*p;
+        if ((unsigned char)(c - 'A') < 26) {
+            upper = 1;
+        } else if (!((unsigned char)(c - 'a') < 26 || (unsigned char)(c - '0') < 10 || c == '_')) {
+            break;
+        }
+    }
+    *has_upper = upper;
+    return p;
+}
+
+const char *scan_number_span(const char *p) {
+    while ((unsigned char)(*p - '0') < 10 || *p == '.') {
+        p++;
+    }
+    return p;
+}
+
+const char *scan_line_starts(const char *origin, const char *p, uint32_t *starts,
+                             size_t *count, size_t capacity) {
+    size_t n = *count;
+    for (; *p != '\0' && n < capacity; p++) {
+        if (*p == '\n') {
+            starts[n++] = (uint32_t)(p + 1 - origin);
+        }
+    }
+    *count = n;
+    return p;
+}
+
+const char *scan_utf8_invalid(const char *p) {
+    for (;;) {
+        while (*p != '\0' && (unsigned char)*p < 0x80) {
+            p++;
+        }
+        if (*p == '\0') return p;
+
+        uint32_t code_point;
+        size_t length = utf8_decode(p, &code_point);
+        if (length == 0) return p;
+        p += length;
+    }
+}
+
+#endif
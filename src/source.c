@@ -0,0 +1,149 @@
+#include "source.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define SOURCE_STREAM_CHUNK (64 * 1024)
+
+// ============================================================================
+// Streaming Fallback
+// ============================================================================
+
+static int stream_source(SourceBuffer* source, int fd) {
+    size_t capacity = SOURCE_STREAM_CHUNK;
+    size_t length = 0;
+    char* buf = (char*)malloc(capacity + 1);
+    if (!buf) {
+        fprintf(stderr, "Error: Memory allocation failed for file buffer\n");
+        return 1;
+    }
+
+    for (;;) {
+        if (capacity - length < SOURCE_STREAM_CHUNK / 2) {
+            capacity *= 2;
+            char* temp = (char*)realloc(buf, capacity + 1);
+            if (!temp) {
+                fprintf(stderr, "Error: Memory allocation failed for file buffer\n");
+                free(buf);
+                return 1;
+            }
+            buf = temp;
+        }
+
+        long n = (long)read(fd, buf + length, (unsigned)(capacity - length));
+        if (n == 0) break;
+        if (n < 0) {
+            perror("Error reading input");
+            free(buf);
+            return 1;
+        }
+        length += (size_t)n;
+    }
+
+    buf[length] = '\0';
+    source->data = buf;
+    source->length = length;
+    source->kind = SOURCE_STREAMED;
+    source->map_size = 0;
+    return 0;
+}
+
+// ============================================================================
+// Memory Mapping
+// ============================================================================
+
+#ifndef _WIN32
+// Maps the file followed by at least one whole page of zeroes: first an
+// anonymous region large enough for both, then the file over its head.
+// The zero page is the NUL terminator, and because it is a full page the
+// kernels' aligned loads past the end never leave mapped memory. Returns
+// non-zero if the file cannot be mapped, so the caller can stream it.
+static int map_source(SourceBuffer* source, int fd, size_t length) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t file_span = (length + page - 1) & ~(page - 1);
+    size_t map_size = file_span + page;
+
+    char* base = (char*)mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return 1;
+
+    // Private and writable so the buffer behaves like the old heap copy;
+    // pages are only copied if something writes to them.
+    if (mmap(base, file_span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, map_size);
+        return 1;
+    }
+    madvise(base, file_span, MADV_SEQUENTIAL);
+
+    source->data = base;
+    source->length = length;
+    source->kind = SOURCE_MAPPED;
+    source->map_size = map_size;
+    return 0;
+}
+#endif
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+int source_load(SourceBuffer* source, const char* path) {
+    memset(source, 0, sizeof(*source));
+
+    int use_stdin = strcmp(path, "-") == 0;
+    int fd = use_stdin ? 0 : open(path, O_RDONLY | O_BINARY);
+    if (fd < 0) {
+        perror("Error opening file");
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("Error checking file size");
+        if (!use_stdin) close(fd);
+        return 1;
+    }
+    source->is_regular_file = S_ISREG(st.st_mode);
+
+    int result = 1;
+#ifndef _WIN32
+    // Empty (or size-less, like /proc) files gain nothing from mapping
+    if (source->is_regular_file && st.st_size > 0) {
+        result = map_source(source, fd, (size_t)st.st_size);
+    }
+#endif
+    if (result != 0) {
+        result = stream_source(source, fd);
+    }
+
+    if (!use_stdin) close(fd);
+    return result;
+}
+
+void source_free(SourceBuffer* source) {
+    if (!source->data) return;
+
+#ifndef _WIN32
+    if (source->kind == SOURCE_MAPPED) {
+        munmap(source->data, source->map_size);
+        source->data = NULL;
+        return;
+    }
+#endif
+    free(source->data);
+    source->data = NULL;
+}
@@ -0,0 +1,290 @@
+#include "stats.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include "scan.h"
+
+// ============================================================================
+// Tokens
+// ============================================================================
+
+// Text between two tokens is whitespace, comments and the quotes around
+// literals; only the first two are counted
+static void count_gap(TokenStats *stats, const char *p, const char *end) {
+    while (p < end) {
+        if (*p == '#') {
+            const char *line_end = scan_to_newline(p);
+            if (line_end > end) line_end = end;
+            stats->comment_bytes += (size_t)(line_end - p);
+            p = line_end;
+        } else {
+            if (isspace((unsigned char)*p)) stats->whitespace_bytes++;
+            p++;
+        }
+    }
+}
+
+void token_stats_collect(Lexer *lexer, TokenStats *stats) {
+    TokenStore *store = &lexer->tokens;
+    memset(stats, 0, sizeof(TokenStats));
+    stats->token_count = store->count;
+
+    size_t gap_start = 0;
+    for (size_t i = 0; i < store->count; i++) {
+        stats->by_type[token_store_type(store, i)]++;
+        count_gap(stats, lexer->start_tok + gap_start, lexer->start_tok + token_store_offset(store, i));
+        gap_start = lexer_token_end(lexer, i);
+    }
+
+    // The EOF token sits on the terminator, so its offset is the length
+    stats->source_bytes = gap_start;
+
+    const BracketPair *brackets = token_store_brackets(store, &stats->bracket_pairs);
+    for (size_t i = 0; i < stats->bracket_pairs; i++) {
+        const BracketPair *pair = &brackets[i];
+        if (pair->open == TOKEN_BRACKET_NONE || pair->close == TOKEN_BRACKET_NONE) {
+            stats->unmatched_brackets++;
+        }
+        if (pair->depth + 1 > stats->max_bracket_depth) stats->max_bracket_depth = pair->depth + 1;
+    }
+
+    symtab_stats(&stats->symbols);
+}
+
+void token_stats_print(FILE *out, const TokenStats *stats) {
+    double source = stats->source_bytes ? (double)stats->source_bytes : 1.0;
+    double tokens = stats->token_count ? (double)stats->token_count : 1.0;
+
+    fprintf(out, "=== Token Statistics ===\n");
+    fprintf(out, "Source bytes:       %zu\n", stats->source_bytes);
+    fprintf(out, "Tokens:             %zu\n", stats->token_count);
+    fprintf(out, "Comment bytes:      %zu (%.1f%%)\n",
+            stats->comment_bytes, 100.0 * (double)stats->comment_bytes / source);
+    fprintf(out, "Whitespace bytes:   %zu (%.1f%%)\n",
+            stats->whitespace_bytes, 100.0 * (double)stats->whitespace_bytes / source);
+    fprintf(out, "Bracket pairs:      %zu (%zu unmatched, max depth %zu)\n",
+            stats->bracket_pairs, stats->unmatched_brackets, stats->max_bracket_depth);
+    fprintf(out, "Symbols:            %zu (%zu lookups, %zu contended)\n\n",
+            stats->symbols.symbols, stats->symbols.lookups, stats->symbols.contended);
+
+    fprintf(out, "%-22s %12s %8s\n", "Token", "Count", "Share");
+    for (int type = 0; type < TOKEN_TYPE_COUNT; type++) {
+        if (stats->by_type[type] == 0) continue;
+        fprintf(out, "%-22s %12zu %7.2f%%\n", token_type_to_string((Token)type),
+                stats->by_type[type], 100.0 * (double)stats->by_type[type] / tokens);
+    }
+    fprintf(out, "\n");
+
+    // Contention only shows with -j; shards are picked by name hash, so
+    // uneven lookups point at a hot name
+    fprintf(out, "%-22s %12s %12s\n", "Symbol shard", "Lookups", "Contended");
+    for (size_t shard = 0; shard < SYMTAB_SHARDS; shard++) {
+        if (stats->symbols.shard_lookups[shard] == 0) continue;
+        fprintf(out, "%-22zu %12zu %12zu\n", shard,
+                stats->symbols.shard_lookups[shard], stats->symbols.shard_contended[shard]);
+    }
+    fprintf(out, "\n");
+}
+
+// ============================================================================
+// AST
+// ============================================================================
+
+static size_t string_bytes(const char *s) {
+    return s ? strlen(s) + 1 : 0;
+}
+
+static void visit_node(AstStats *stats, const ASTNode *node, size_t depth);
+
+static void visit_list(AstStats *stats, ASTNode *const *nodes, size_t count, size_t depth) {
+    for (size_t i = 0; i < count; i++) {
+        visit_node(stats, nodes[i], depth);
+    }
+}
+
+// Counts what each node takes from the parser's arena, before alignment:
+// the node itself, payload included, plus its arrays, parameters and
+// strings. The type name shared by the declarations of one statement is
+// counted with each of them.
+static void visit_node(AstStats *stats, const ASTNode *node, size_t depth) {
+    if (!node) return;
+
+    stats->node_count++;
+    stats->by_type[node->type]++;
+    if (depth > stats->max_depth) stats->max_depth = depth;
+
+    size_t bytes = sizeof(ASTNode);
+    size_t child_depth = depth + 1;
+
+    switch (node->type) {
+        case NODE_STATEMENT_LIST:
+        case NODE_BLOCK: {
+            const StatementListNode *list = &node->list;
+            bytes += list->count * sizeof(ASTNode *);
+            stats->statement_lists++;
+            stats->statements += list->count;
+            visit_list(stats, list->statements, list->count, child_depth);
+            break;
+        }
+
+        case NODE_PROGRAM: {
+            const ProgramNode *prog = &node->program;
+            bytes += prog->global_count * sizeof(ASTNode *);
+            visit_list(stats, prog->global_decls, prog->global_count, child_depth);
+            visit_node(stats, prog->stmt_list, child_depth);
+            break;
+        }
+
+        case NODE_VAR_DECL: {
+            const VarDeclNode *var = &node->var_decl;
+            bytes += string_bytes(var->data_type);
+            visit_node(stats, var->init_expr, child_depth);
+            break;
+        }
+
+        case NODE_FUNC_DECL: {
+            const FuncDeclNode *func = &node->func_decl;
+            bytes += string_bytes(func->return_type);
+            visit_node(stats, func->params, child_depth);
+            visit_node(stats, func->body, child_depth);
+            break;
+        }
+
+        case NODE_PARAM_LIST: {
+            const ParameterListNode *params = &node->param_list;
+            // Every array the list outgrew is still in the arena
+            for (size_t capacity = AST_PARAM_LIST_CAPACITY; capacity <= params->capacity; capacity *= 2) {
+                bytes += capacity * sizeof(ParameterNode *);
+            }
+            for (size_t i = 0; i < params->count; i++) {
+                bytes += sizeof(ParameterNode) + string_bytes(params->parameters[i]->param_type);
+            }
+            break;
+        }
+
+        case NODE_DECL_STMT: {
+            const DeclStmtNode *decl = &node->decl_stmt;
+            visit_node(stats, decl->decl, child_depth);
+            break;
+        }
+
+        case NODE_ASSIGN_STMT: {
+            const AssignStmtNode *assign = &node->assign;
+            visit_node(stats, assign->expr, child_depth);
+            break;
+        }
+
+        case NODE_INPUT_STMT: {
+            const InputStmtNode *input = &node->input;
+            bytes += string_bytes(input->data_type);
+            break;
+        }
+
+        case NODE_OUTPUT_STMT: {
+            const OutputStmtNode *output = &node->output;
+            visit_node(stats, output->expr, child_depth);
+            break;
+        }
+
+        case NODE_COND_STMT: {
+            const CondStmtNode *cond = &node->cond;
+            visit_node(stats, cond->condition, child_depth);
+            visit_node(stats, cond->then_body, child_depth);
+            visit_node(stats, cond->else_body, child_depth);
+            break;
+        }
+
+        case NODE_ITER_STMT: {
+            const IterStmtNode *iter = &node->iter;
+            visit_node(stats, iter->init, child_depth);
+            visit_node(stats, iter->condition, child_depth);
+            visit_node(stats, iter->increment, child_depth);
+            visit_node(stats, iter->body, child_depth);
+            break;
+        }
+
+        case NODE_RETURN_STMT: {
+            const ReturnStmtNode *ret = &node->ret;
+            visit_node(stats, ret->expr, child_depth);
+            break;
+        }
+
+        case NODE_FUNC_CALL: {
+            const FuncCallNode *call = &node->call;
+            bytes += call->count * sizeof(ASTNode *);
+            stats->calls++;
+            stats->call_arguments += call->count;
+            visit_list(stats, call->arguments, call->count, child_depth);
+            break;
+        }
+
+        case NODE_BINARY_EXPR: {
+            const BinaryExpressionNode *binop = &node->binary;
+            visit_node(stats, binop->left, child_depth);
+            visit_node(stats, binop->right, child_depth);
+            break;
+        }
+
+        case NODE_UNARY_EXPR: {
+            const UnaryExpressionNode *unop = &node->unary;
+            visit_node(stats, unop->operand, child_depth);
+            break;
+        }
+
+        case NODE_LITERAL: {
+            const LiteralNode *lit = &node->literal;
+            if (lit->literal_type == LITERAL_STRING) {
+                bytes += string_bytes(lit->value.string_value);
+            }
+            break;
+        }
+
+        case NODE_ARG_LIST: {
+            const ArgListNode *args = &node->arg_list;
+            bytes += args->count * sizeof(ASTNode *);
+            visit_list(stats, args->args, args->count, child_depth);
+            break;
+        }
+
+        case NODE_IDENTIFIER:
+        case NODE_CONTINUE_STMT:
+        case NODE_STOP_STMT:
+            break;
+    }
+
+    stats->bytes_by_type[node->type] += bytes;
+}
+
+void ast_stats_collect(const ASTNode *root, AstStats *stats) {
+    memset(stats, 0, sizeof(AstStats));
+    visit_node(stats, root, 1);
+}
+
+void ast_stats_print(FILE *out, const AstStats *stats) {
+    size_t total_bytes = 0;
+    for (int type = 0; type < AST_NODE_TYPE_COUNT; type++) {
+        total_bytes += stats->bytes_by_type[type];
+    }
+    double nodes = stats->node_count ? (double)stats->node_count : 1.0;
+
+    fprintf(out, "=== AST Statistics ===\n");
+    fprintf(out, "Nodes:              %zu\n", stats->node_count);
+    fprintf(out, "Bytes:              %zu (%.1f per node)\n", total_bytes, (double)total_bytes / nodes);
+    fprintf(out, "Max depth:          %zu\n", stats->max_depth);
+    fprintf(out, "Statement fan-out:  %.2f (%zu lists)\n",
+            stats->statement_lists ? (double)stats->statements / (double)stats->statement_lists : 0.0,
+            stats->statement_lists);
+    fprintf(out, "Call fan-out:       %.2f (%zu calls)\n\n",
+            stats->calls ? (double)stats->call_arguments / (double)stats->calls : 0.0,
+            stats->calls);
+
+    fprintf(out, "%-22s %12s %14s %10s\n", "Node", "Count", "Bytes", "Bytes/node");
+    for (int type = 0; type < AST_NODE_TYPE_COUNT; type++) {
+        if (stats->by_type[type] == 0) continue;
+        fprintf(out, "NODE_%-17s %12zu %14zu %10.1f\n", ast_node_type_name((ASTNodeType)type),
+                stats->by_type[type], stats->bytes_by_type[type],
+                (double)stats->bytes_by_type[type] / (double)stats->by_type[type]);
+    }
+    fprintf(out, "\n");
+}
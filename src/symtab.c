@@ -0,0 +1,286 @@
+#include "symtab.h"
+#include "arena.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Table Layout
+// ============================================================================
+//
+// The top SYMTAB_SHARD_BITS of a name's hash pick its shard; the low bits
+// pick its slot inside the shard. Each shard is an open-addressing table
+// over `slots` (0 marks an empty slot), kept at most half full, guarded by
+// its own mutex.
+//
+// A SymbolId is ((local index + 1) << SYMTAB_SHARD_BITS) | shard, so 0 is
+// never a valid id and the shard is recovered without a lookup. Entries are
+// stored in segments that double in size and are never moved, and names
+// live in a per-shard arena; readers can therefore resolve an id without
+// taking the lock while another thread is inserting into the same shard.
+
+typedef struct {
+    const char* name;
+    uint32_t length;
+    uint32_t hash;
+} SymbolEntry;
+
+#define SYMTAB_INITIAL_SLOTS 256
+#define SYMTAB_SEGMENT_BITS 8 // Segment k holds 1 << (SYMTAB_SEGMENT_BITS + k) entries
+#define SYMTAB_MAX_SEGMENTS (32 - SYMTAB_SHARD_BITS - SYMTAB_SEGMENT_BITS)
+
+typedef struct {
+    pthread_mutex_t lock;
+
+    SymbolId* slots;
+    size_t slot_capacity;   // Power of two
+    SymbolEntry* segments[SYMTAB_MAX_SEGMENTS];
+    _Atomic size_t entry_count;
+    Arena names;
+
+    // Updated under `lock`
+    size_t lookups;
+    size_t contended;
+} SymbolShard;
+
+static SymbolShard shards[SYMTAB_SHARDS];
+static pthread_once_t shards_once = PTHREAD_ONCE_INIT;
+
+static void init_shard_locks(void) {
+    for (size_t i = 0; i < SYMTAB_SHARDS; i++) {
+        pthread_mutex_init(&shards[i].lock, NULL);
+    }
+}
+
+static void out_of_memory(void) {
+    fprintf(stderr, "Fatal Error: Memory allocation failed for symbol table\n");
+    exit(1);
+}
+
+static inline unsigned char fold(unsigned char c) {
+    return (unsigned char)(c - 'A') < 26 ? (unsigned char)(c | 0x20) : c;
+}
+
+// FNV-1a over the (optionally folded) bytes
+static uint32_t hash_name(const char* name, size_t length, int lower) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)name[i];
+        hash ^= lower ? fold(c) : c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int name_equals(const SymbolEntry* entry, const char* name, size_t length, int lower) {
+    if (entry->length != length) return 0;
+    if (!lower) return memcmp(entry->name, name, length) == 0;
+
+    for (size_t i = 0; i < length; i++) {
+        if ((unsigned char)entry->name[i] != fold((unsigned char)name[i])) return 0;
+    }
+    return 1;
+}
+
+// ============================================================================
+// Entry Segments
+// ============================================================================
+
+static inline size_t segment_of(size_t local, size_t* offset) {
+    size_t biased = local + ((size_t)1 << SYMTAB_SEGMENT_BITS);
+    size_t top = (size_t)(63 - __builtin_clzll((unsigned long long)biased));
+    *offset = biased - ((size_t)1 << top);
+    return top - SYMTAB_SEGMENT_BITS;
+}
+
+static SymbolEntry* shard_entry(SymbolShard* shard, size_t local) {
+    size_t offset;
+    size_t segment = segment_of(local, &offset);
+    return &shard->segments[segment][offset];
+}
+
+static inline SymbolId make_id(size_t shard, size_t local) {
+    return (SymbolId)(((local + 1) << SYMTAB_SHARD_BITS) | shard);
+}
+
+static inline size_t id_local(SymbolId id) {
+    return ((size_t)id >> SYMTAB_SHARD_BITS) - 1;
+}
+
+// ============================================================================
+// Insertion (shard lock held)
+// ============================================================================
+
+static void shard_init(SymbolShard* shard) {
+    shard->slot_capacity = SYMTAB_INITIAL_SLOTS;
+    shard->slots = (SymbolId*)calloc(shard->slot_capacity, sizeof(SymbolId));
+    if (!shard->slots) out_of_memory();
+    arena_init(&shard->names, 0);
+}
+
+static void shard_grow(SymbolShard* shard) {
+    size_t new_capacity = shard->slot_capacity * 2;
+    SymbolId* new_slots = (SymbolId*)calloc(new_capacity, sizeof(SymbolId));
+    if (!new_slots) out_of_memory();
+
+    for (size_t i = 0; i < shard->slot_capacity; i++) {
+        SymbolId id = shard->slots[i];
+        if (id == SYMBOL_NONE) continue;
+
+        size_t j = shard_entry(shard, id_local(id))->hash & (new_capacity - 1);
+        while (new_slots[j] != SYMBOL_NONE) {
+            j = (j + 1) & (new_capacity - 1);
+        }
+        new_slots[j] = id;
+    }
+
+    free(shard->slots);
+    shard->slots = new_slots;
+    shard->slot_capacity = new_capacity;
+}
+
+static SymbolId shard_insert(SymbolShard* shard, size_t shard_index, size_t slot,
+                             const char* name, size_t length, uint32_t hash, int lower) {
+    size_t local = atomic_load_explicit(&shard->entry_count, memory_order_relaxed);
+    size_t offset;
+    size_t segment = segment_of(local, &offset);
+    if (segment >= SYMTAB_MAX_SEGMENTS) {
+        fprintf(stderr, "Fatal Error: Symbol table is full\n");
+        exit(1);
+    }
+    if (!shard->segments[segment]) {
+        size_t size = (size_t)1 << (SYMTAB_SEGMENT_BITS + segment);
+        shard->segments[segment] = (SymbolEntry*)malloc(size * sizeof(SymbolEntry));
+        if (!shard->segments[segment]) out_of_memory();
+    }
+
+    char* text = arena_strndup(&shard->names, name, length);
+    if (lower) {
+        for (size_t k = 0; k < length; k++) {
+            text[k] = (char)fold((unsigned char)text[k]);
+        }
+    }
+
+    shard->segments[segment][offset] = (SymbolEntry){text, (uint32_t)length, hash};
+    // Publish the entry to lock-free readers
+    atomic_store_explicit(&shard->entry_count, local + 1, memory_order_release);
+
+    SymbolId id = make_id(shard_index, local);
+    shard->slots[slot] = id;
+    if ((local + 1) * 2 > shard->slot_capacity) {
+        shard_grow(shard);
+    }
+    return id;
+}
+
+static SymbolId intern(const char* name, size_t length, int lower) {
+    pthread_once(&shards_once, init_shard_locks);
+
+    uint32_t hash = hash_name(name, length, lower);
+    size_t shard_index = hash >> (32 - SYMTAB_SHARD_BITS);
+    SymbolShard* shard = &shards[shard_index];
+
+    int contended = 0;
+    if (pthread_mutex_trylock(&shard->lock) != 0) {
+        contended = 1;
+        pthread_mutex_lock(&shard->lock);
+    }
+    shard->lookups++;
+    shard->contended += (size_t)contended;
+
+    if (!shard->slots) shard_init(shard);
+
+    size_t mask = shard->slot_capacity - 1;
+    size_t i = hash & mask;
+    SymbolId id;
+
+    while ((id = shard->slots[i]) != SYMBOL_NONE) {
+        const SymbolEntry* entry = shard_entry(shard, id_local(id));
+        if (entry->hash == hash && name_equals(entry, name, length, lower)) {
+            pthread_mutex_unlock(&shard->lock);
+            return id;
+        }
+        i = (i + 1) & mask;
+    }
+
+    id = shard_insert(shard, shard_index, i, name, length, hash, lower);
+    pthread_mutex_unlock(&shard->lock);
+    return id;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+SymbolId symbol_intern(const char* name, size_t length) {
+    return intern(name, length, 0);
+}
+
+SymbolId symbol_intern_lower(const char* name, size_t length) {
+    return intern(name, length, 1);
+}
+
+static const SymbolEntry* lookup_entry(SymbolId id) {
+    if (id == SYMBOL_NONE) return NULL;
+
+    SymbolShard* shard = &shards[id & (SYMTAB_SHARDS - 1)];
+    size_t local = id_local(id);
+    if (local >= atomic_load_explicit(&shard->entry_count, memory_order_acquire)) return NULL;
+    return shard_entry(shard, local);
+}
+
+const char* symbol_name(SymbolId id) {
+    const SymbolEntry* entry = lookup_entry(id);
+    return entry ? entry->name : NULL;
+}
+
+size_t symbol_length(SymbolId id) {
+    const SymbolEntry* entry = lookup_entry(id);
+    return entry ? entry->length : 0;
+}
+
+size_t symbol_count(void) {
+    size_t count = 0;
+    for (size_t i = 0; i < SYMTAB_SHARDS; i++) {
+        count += atomic_load_explicit(&shards[i].entry_count, memory_order_relaxed);
+    }
+    return count;
+}
+
+void symtab_stats(SymtabStats* stats) {
+    pthread_once(&shards_once, init_shard_locks);
+    memset(stats, 0, sizeof(*stats));
+
+    for (size_t i = 0; i < SYMTAB_SHARDS; i++) {
+        SymbolShard* shard = &shards[i];
+        pthread_mutex_lock(&shard->lock);
+        stats->symbols += atomic_load_explicit(&shard->entry_count, memory_order_relaxed);
+        stats->shard_lookups[i] = shard->lookups;
+        stats->shard_contended[i] = shard->contended;
+        pthread_mutex_unlock(&shard->lock);
+
+        stats->lookups += stats->shard_lookups[i];
+        stats->contended += stats->shard_contended[i];
+    }
+}
+
+void symtab_free(void) {
+    for (size_t i = 0; i < SYMTAB_SHARDS; i++) {
+        SymbolShard* shard = &shards[i];
+        free(shard->slots);
+        for (size_t s = 0; s < SYMTAB_MAX_SEGMENTS; s++) {
+            free(shard->segments[s]);
+            shard->segments[s] = NULL;
+        }
+        arena_free(&shard->names);
+
+        shard->slots = NULL;
+        shard->slot_capacity = 0;
+        atomic_store_explicit(&shard->entry_count, 0, memory_order_relaxed);
+        shard->lookups = 0;
+        shard->contended = 0;
+    }
+}
@@ -0,0 +1,466 @@
+#include "token_cache.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define TOKEN_CACHE_MAGIC "ECTOKENS"
+#define TOKEN_CACHE_UNICODE_IDENTIFIERS 1u
+
+// ============================================================================
+// Source Hash
+// ============================================================================
+//
+// XXH64: four independent 8-byte lanes per 32-byte stripe, so hashing runs
+// at several bytes per cycle and costs far less than lexing.
+
+#define PRIME64_1 0x9E3779B185EBCA87ull
+#define PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define PRIME64_3 0x165667B19E3779F9ull
+#define PRIME64_4 0x85EBCA77C2B2AE63ull
+#define PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t rotl64(uint64_t x, unsigned r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t hash_merge(uint64_t acc, uint64_t lane) {
+    acc ^= hash_round(0, lane);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+static uint64_t hash_bytes(const char* p, size_t length, uint64_t seed) {
+    const char* end = p + length;
+    uint64_t h;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        do {
+            v1 = hash_round(v1, read64(p));
+            v2 = hash_round(v2, read64(p + 8));
+            v3 = hash_round(v3, read64(p + 16));
+            v4 = hash_round(v4, read64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = hash_merge(h, v1);
+        h = hash_merge(h, v2);
+        h = hash_merge(h, v3);
+        h = hash_merge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += (uint64_t)length;
+
+    for (; end - p >= 8; p += 8) {
+        h ^= hash_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (end - p >= 4) {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (uint64_t)(unsigned char)*p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+TokenCacheKey token_cache_key(const Lexer* lexer, size_t length) {
+    TokenCacheKey key;
+    key.flags = lexer->unicode_identifiers ? TOKEN_CACHE_UNICODE_IDENTIFIERS : 0;
+    key.length = length;
+    key.hash = hash_bytes(lexer->start_tok, length, ((uint64_t)TOKEN_CACHE_VERSION << 32) | key.flags);
+    return key;
+}
+
+#ifndef _WIN32
+
+// ============================================================================
+// File Layout
+// ============================================================================
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t hash;
+    uint64_t source_length;
+    uint64_t token_count;
+    uint64_t number_count;
+    uint64_t string_count;
+    uint64_t string_bytes;
+    uint64_t name_count;
+    uint64_t name_bytes;
+} TokenCacheHeader;
+
+// Byte offsets of each section. The token arrays follow the header in
+// TokenStore order (offsets | data | types), so a mapped file can serve as
+// the store's block directly.
+typedef struct {
+    size_t offsets;
+    size_t data;
+    size_t types;
+    size_t numbers;         // NumberValue[number_count]
+    size_t string_lengths;  // uint32_t[string_count]
+    size_t name_lengths;    // uint32_t[name_count]
+    size_t string_bytes;
+    size_t name_bytes;
+    size_t end;
+} CacheLayout;
+
+static CacheLayout cache_layout(const TokenCacheHeader* header) {
+    CacheLayout layout;
+    layout.offsets = sizeof(TokenCacheHeader);
+    layout.data = layout.offsets + header->token_count * sizeof(uint32_t);
+    layout.types = layout.data + header->token_count * sizeof(uint32_t);
+    layout.numbers = (layout.types + header->token_count + 7) & ~(size_t)7;
+    layout.string_lengths = layout.numbers + header->number_count * sizeof(NumberValue);
+    layout.name_lengths = layout.string_lengths + header->string_count * sizeof(uint32_t);
+    layout.string_bytes = layout.name_lengths + header->name_count * sizeof(uint32_t);
+    layout.name_bytes = layout.string_bytes + header->string_bytes;
+    layout.end = layout.name_bytes + header->name_bytes;
+    return layout;
+}
+
+static void cache_path(char* path, size_t size, const char* dir, const TokenCacheKey* key) {
+    snprintf(path, size, "%s/%016" PRIx64 ".tok", dir, key->hash);
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+// The counts are bounded by what a cache file written here can hold, so a
+// damaged header cannot overflow the layout arithmetic.
+static int header_matches(const TokenCacheHeader* header, const TokenCacheKey* key) {
+    return memcmp(header->magic, TOKEN_CACHE_MAGIC, sizeof(header->magic)) == 0 &&
+           header->version == TOKEN_CACHE_VERSION &&
+           header->flags == key->flags &&
+           header->hash == key->hash &&
+           header->source_length == key->length &&
+           header->token_count <= UINT32_MAX &&
+           header->number_count <= UINT32_MAX &&
+           header->string_count <= UINT32_MAX &&
+           header->name_count <= UINT32_MAX &&
+           header->string_bytes <= TOKEN_STORE_MAX_SOURCE &&
+           header->name_bytes <= TOKEN_STORE_MAX_SOURCE;
+}
+
+static int lengths_add_up(const char* base, size_t count, uint64_t total) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += read32(base + i * sizeof(uint32_t));
+    }
+    return sum == total;
+}
+
+static int sections_match(const char* map, size_t size, const CacheLayout* layout) {
+    const TokenCacheHeader* header = (const TokenCacheHeader*)map;
+    return layout->end == size &&
+           lengths_add_up(map + layout->string_lengths, header->string_count, header->string_bytes) &&
+           lengths_add_up(map + layout->name_lengths, header->name_count, header->name_bytes);
+}
+
+// Interns the file's names and replaces identifier data with their ids,
+// checking every token on the way. Returns 0 if any is out of range or
+// would be viewed past the end of the source.
+static int resolve_tokens(char* map, const CacheLayout* layout, size_t source_length) {
+    const TokenCacheHeader* header = (const TokenCacheHeader*)map;
+    const uint32_t* offsets = (const uint32_t*)(map + layout->offsets);
+    uint32_t* data = (uint32_t*)(map + layout->data);
+    const uint8_t* types = (const uint8_t*)(map + layout->types);
+
+    SymbolId* names = (SymbolId*)malloc((header->name_count + 1) * sizeof(SymbolId));
+    if (!names) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for token cache\n");
+        exit(1);
+    }
+    const char* name = map + layout->name_bytes;
+    for (size_t i = 0; i < header->name_count; i++) {
+        uint32_t length = read32(map + layout->name_lengths + i * sizeof(uint32_t));
+        names[i] = symbol_intern(name, length);
+        name += length;
+    }
+
+    size_t i = 0;
+    for (; i < header->token_count; i++) {
+        Token type = (Token)types[i];
+        if (type > TOKEN_EOF || offsets[i] > source_length) break;
+        if (type == TOKEN_IDENTIFIER) {
+            if (data[i] >= header->name_count) break;
+            data[i] = names[data[i]];
+        } else if (TOKEN_HAS_NUMBER(type)) {
+            if (data[i] >= header->number_count) break;
+        } else if (TOKEN_HAS_STRING(type, data[i])) {
+            if ((data[i] & ~TOKEN_STRING_SLOT) >= header->string_count) break;
+        } else {
+            // Everything else is viewed as `data` bytes of source (one for
+            // a bracket, whose data is rebuilt when first asked for)
+            size_t length = TOKEN_IS_BRACKET(type) ? 1 : data[i];
+            if ((size_t)offsets[i] + length > source_length) break;
+        }
+    }
+    free(names);
+    return i == header->token_count;
+}
+
+int token_cache_load(const char* dir, const TokenCacheKey* key, Lexer* lexer) {
+    char path[4096];
+    cache_path(path, sizeof(path), dir, key);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TokenCacheHeader)) {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+
+    // Private and writable: identifiers are renumbered in place, and only
+    // the pages touched are copied
+    char* map = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+
+    const TokenCacheHeader* header = (const TokenCacheHeader*)map;
+    CacheLayout layout = cache_layout(header);
+    if (!header_matches(header, key) ||
+        !sections_match(map, size, &layout) ||
+        !resolve_tokens(map, &layout, key->length)) {
+        munmap(map, size);
+        return 0;
+    }
+
+    TokenStore* store = &lexer->tokens;
+    token_store_free(store);
+    store->offsets = (uint32_t*)(map + layout.offsets);
+    store->data = (uint32_t*)(map + layout.data);
+    store->types = (uint8_t*)(map + layout.types);
+    store->count = header->token_count;
+    store->capacity = header->token_count;
+    store->mapping = map;
+    store->mapping_size = size;
+
+    const NumberValue* numbers = (const NumberValue*)(map + layout.numbers);
+    for (size_t i = 0; i < header->number_count; i++) {
+        token_store_add_number(store, numbers[i]);
+    }
+    const char* text = map + layout.string_bytes;
+    for (size_t i = 0; i < header->string_count; i++) {
+        uint32_t length = read32(map + layout.string_lengths + i * sizeof(uint32_t));
+        token_store_add_string(store, text, length);
+        text += length;
+    }
+
+    lexer->cur_tok = lexer->start_tok + key->length;
+    lexer->token_start = lexer->cur_tok;
+    return 1;
+}
+
+// ============================================================================
+// Storing
+// ============================================================================
+
+// SymbolId -> index in the file's name list, by open addressing. SymbolIds
+// are never SYMBOL_NONE, which marks an empty slot.
+typedef struct {
+    SymbolId* keys;
+    uint32_t* values;
+    size_t capacity;
+    SymbolId* names;        // In order of first use
+    size_t count;
+} NameMap;
+
+static void name_map_init(NameMap* map, size_t capacity) {
+    map->keys = (SymbolId*)calloc(capacity, sizeof(SymbolId));
+    map->values = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    map->names = (SymbolId*)malloc(capacity / 2 * sizeof(SymbolId));
+    if (!map->keys || !map->values || !map->names) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for token cache\n");
+        exit(1);
+    }
+    map->capacity = capacity;
+    map->count = 0;
+}
+
+static void name_map_free(NameMap* map) {
+    free(map->keys);
+    free(map->values);
+    free(map->names);
+}
+
+static uint32_t name_index(NameMap* map, SymbolId id) {
+    size_t mask = map->capacity - 1;
+    size_t slot = (id * 2654435761u) & mask;
+    while (map->keys[slot] != SYMBOL_NONE) {
+        if (map->keys[slot] == id) return map->values[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t index = (uint32_t)map->count;
+    map->keys[slot] = id;
+    map->values[slot] = index;
+    map->names[map->count++] = id;
+
+    // At most half full
+    if (map->count * 2 >= map->capacity) {
+        NameMap grown;
+        name_map_init(&grown, map->capacity * 2);
+        for (size_t i = 0; i < map->count; i++) {
+            name_index(&grown, map->names[i]);
+        }
+        name_map_free(map);
+        *map = grown;
+    }
+    return index;
+}
+
+int token_cache_store(const char* dir, const TokenCacheKey* key, Lexer* lexer) {
+    TokenStore* store = &lexer->tokens;
+    token_store_flatten(store);
+    size_t count = store->count;
+
+    uint32_t* data = (uint32_t*)malloc((count + 1) * sizeof(uint32_t));
+    if (!data) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for token cache\n");
+        exit(1);
+    }
+    NameMap names;
+    name_map_init(&names, 256);
+
+    for (size_t i = 0; i < count; i++) {
+        if (store->types[i] == INVALID) {
+            // Diagnostics would be lost on a hit
+            name_map_free(&names);
+            free(data);
+            return 0;
+        }
+        data[i] = store->types[i] == TOKEN_IDENTIFIER ? name_index(&names, (SymbolId)store->data[i])
+                                                      : store->data[i];
+    }
+
+    TokenCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TOKEN_CACHE_MAGIC, sizeof(header.magic));
+    header.version = TOKEN_CACHE_VERSION;
+    header.flags = key->flags;
+    header.hash = key->hash;
+    header.source_length = key->length;
+    header.token_count = count;
+    header.number_count = store->number_count;
+    header.string_count = store->string_count;
+    header.name_count = names.count;
+    for (size_t i = 0; i < store->string_count; i++) {
+        header.string_bytes += store->strings[i].length;
+    }
+    for (size_t i = 0; i < names.count; i++) {
+        header.name_bytes += symbol_length(names.names[i]);
+    }
+    CacheLayout layout = cache_layout(&header);
+
+    char path[4096];
+    char temp[4096 + 32];
+    cache_path(path, sizeof(path), dir, key);
+    snprintf(temp, sizeof(temp), "%s.%ld", path, (long)getpid());
+
+    FILE* out = fopen(temp, "wb");
+    if (!out && errno == ENOENT && mkdir(dir, 0777) == 0) {
+        out = fopen(temp, "wb");
+    }
+    int failed = out == NULL;
+
+    if (out) {
+        static const char padding[8] = {0};
+        fwrite(&header, sizeof(header), 1, out);
+        fwrite(store->offsets, sizeof(uint32_t), count, out);
+        fwrite(data, sizeof(uint32_t), count, out);
+        fwrite(store->types, sizeof(uint8_t), count, out);
+        fwrite(padding, 1, layout.numbers - (layout.types + count), out);
+        fwrite(store->numbers, sizeof(NumberValue), store->number_count, out);
+        for (size_t i = 0; i < store->string_count; i++) {
+            uint32_t length = (uint32_t)store->strings[i].length;
+            fwrite(&length, sizeof(length), 1, out);
+        }
+        for (size_t i = 0; i < names.count; i++) {
+            uint32_t length = (uint32_t)symbol_length(names.names[i]);
+            fwrite(&length, sizeof(length), 1, out);
+        }
+        for (size_t i = 0; i < store->string_count; i++) {
+            fwrite(store->strings[i].text, 1, store->strings[i].length, out);
+        }
+        for (size_t i = 0; i < names.count; i++) {
+            fwrite(symbol_name(names.names[i]), 1, symbol_length(names.names[i]), out);
+        }
+        failed = ferror(out) != 0;
+        failed |= fclose(out) != 0;
+        if (!failed) failed = rename(temp, path) != 0;
+        if (failed) remove(temp);
+    }
+
+    name_map_free(&names);
+    free(data);
+    if (failed) {
+        fprintf(stderr, "Warning: Could not write token cache file '%s'\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+#else // No mmap: the cache is disabled
+
+int token_cache_load(const char* dir, const TokenCacheKey* key, Lexer* lexer) {
+    (void)dir;
+    (void)key;
+    (void)lexer;
+    return 0;
+}
+
+int token_cache_store(const char* dir, const TokenCacheKey* key, Lexer* lexer) {
+    (void)dir;
+    (void)key;
+    (void)lexer;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,367 @@
+#include "token_dump.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#define TOKEN_DUMP_MAGIC "ECTKDUMP"
+#define TOKEN_DUMP_BUFFER_SIZE (1u << 20)
+
+// Lexemes at least this long skip the buffer and are written straight
+// from the source (or decoded string) alongside it
+#define TOKEN_DUMP_DIRECT_MIN (64u * 1024)
+
+// ============================================================================
+// Output Buffer
+// ============================================================================
+
+typedef struct {
+    int fd;
+    char* buf;
+    size_t length;
+    int failed;         // A write failed; later output is dropped
+} DumpWriter;
+
+// Writes two pieces back to back, retrying interrupted and partial writes
+static int write_pieces(int fd, const char* a, size_t a_len, const char* b, size_t b_len) {
+    while (a_len + b_len > 0) {
+#ifdef _WIN32
+        const char* p = a_len > 0 ? a : b;
+        size_t n = a_len > 0 ? a_len : b_len;
+        int written = _write(fd, p, n > 0x40000000u ? 0x40000000u : (unsigned)n);
+#else
+        struct iovec iov[2] = {
+            {(void*)a, a_len},
+            {(void*)b, b_len},
+        };
+        ssize_t written = a_len > 0 ? writev(fd, iov, 2) : write(fd, b, b_len);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 1;
+        }
+
+        size_t done = (size_t)written;
+        size_t from_a = done < a_len ? done : a_len;
+        a += from_a;
+        a_len -= from_a;
+        done -= from_a;
+        b += done;
+        b_len -= done;
+    }
+    return 0;
+}
+
+static void writer_flush(DumpWriter* writer) {
+    if (!writer->failed && write_pieces(writer->fd, writer->buf, writer->length, NULL, 0) != 0) {
+        writer->failed = 1;
+    }
+    writer->length = 0;
+}
+
+// Room for at least `size` bytes, a few dozen at most, at the end of the
+// buffer; the caller advances writer->length by what it used
+static inline char* writer_reserve(DumpWriter* writer, size_t size) {
+    if (TOKEN_DUMP_BUFFER_SIZE - writer->length < size) {
+        writer_flush(writer);
+    }
+    return writer->buf + writer->length;
+}
+
+static void writer_put_slow(DumpWriter* writer, const char* p, size_t n) {
+    if (n < TOKEN_DUMP_DIRECT_MIN) {
+        writer_flush(writer);
+        memcpy(writer->buf, p, n);
+        writer->length = n;
+        return;
+    }
+    if (!writer->failed && write_pieces(writer->fd, writer->buf, writer->length, p, n) != 0) {
+        writer->failed = 1;
+    }
+    writer->length = 0;
+}
+
+static inline void writer_put(DumpWriter* writer, const char* p, size_t n) {
+    if (n <= TOKEN_DUMP_BUFFER_SIZE - writer->length) {
+        memcpy(writer->buf + writer->length, p, n);
+        writer->length += n;
+        return;
+    }
+    writer_put_slow(writer, p, n);
+}
+
+static inline void writer_spaces(DumpWriter* writer, size_t n) {
+    memset(writer_reserve(writer, n), ' ', n);
+    writer->length += n;
+}
+
+// Appends the decimal digits of `value`
+static inline void writer_u64(DumpWriter* writer, uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[sizeof(digits) - ++n] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    writer_put(writer, digits + sizeof(digits) - n, n);
+}
+
+static inline void writer_i64(DumpWriter* writer, int64_t value) {
+    if (value < 0) {
+        writer_put(writer, "-", 1);
+        writer_u64(writer, 0 - (uint64_t)value);
+    } else {
+        writer_u64(writer, (uint64_t)value);
+    }
+}
+
+static inline void writer_le(DumpWriter* writer, uint64_t value, size_t bytes) {
+    char* out = writer_reserve(writer, bytes);
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (char)(value >> (8 * i));
+    }
+    writer->length += bytes;
+}
+
+#define WRITE_LITERAL(writer, text) writer_put((writer), (text), sizeof(text) - 1)
+
+// ============================================================================
+// Table
+// ============================================================================
+
+#define TABLE_RULE "------------------------------------------\n"
+#define TABLE_LEXEME_WIDTH 20
+#define TABLE_NAME_WIDTH 15
+
+// " | <name padded to 15> |\n" for every type, so each row is the lexeme
+// plus one copy
+typedef struct {
+    char text[TOKEN_TYPE_COUNT][64];
+    uint8_t length[TOKEN_TYPE_COUNT];
+} RowTails;
+
+static void build_row_tails(RowTails* tails) {
+    for (int type = 0; type < TOKEN_TYPE_COUNT; type++) {
+        int n = snprintf(tails->text[type], sizeof(tails->text[type]), " | %-*s |\n",
+                         TABLE_NAME_WIDTH, token_type_to_string((Token)type));
+        tails->length[type] = (uint8_t)n;
+    }
+}
+
+static void dump_table(const Lexer* lexer, DumpWriter* writer) {
+    RowTails* tails = (RowTails*)malloc(sizeof(RowTails));
+    if (!tails) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for token dump\n");
+        exit(1);
+    }
+    build_row_tails(tails);
+
+    WRITE_LITERAL(writer, "\n\n" TABLE_RULE);
+    WRITE_LITERAL(writer, "| Lexeme               | Token           |\n");
+    WRITE_LITERAL(writer, TABLE_RULE);
+
+    for (size_t i = 0; i < lexer->tokens.count; i++) {
+        TokenData token = lexer_token_view(lexer, i);
+        const char* text = token.val ? token.val : "(null)";
+        size_t length = token.val ? token.len : 6;
+
+        // The table used to be printed with "%.*s", which stops at a NUL;
+        // only a decoded "\0" escape can put one in a lexeme
+        if (token.type == TOKEN_STR_LIT) {
+            const char* nul = (const char*)memchr(text, '\0', length);
+            if (nul) length = (size_t)(nul - text);
+        }
+
+        WRITE_LITERAL(writer, "| ");
+        writer_put(writer, text, length);
+        if (length < TABLE_LEXEME_WIDTH) {
+            writer_spaces(writer, TABLE_LEXEME_WIDTH - length);
+        }
+        writer_put(writer, tails->text[token.type], tails->length[token.type]);
+    }
+
+    WRITE_LITERAL(writer, TABLE_RULE);
+    free(tails);
+}
+
+// ============================================================================
+// JSON Lines
+// ============================================================================
+
+// Bytes that cannot appear unescaped in a JSON string. The source is valid
+// UTF-8, so everything from 0x80 up is copied as it is.
+static inline int json_needs_escape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+static void writer_json_string(DumpWriter* writer, const char* text, size_t length) {
+    static const char HEX[] = "0123456789abcdef";
+
+    writer_put(writer, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (!json_needs_escape(c)) continue;
+
+        writer_put(writer, text + run, i - run);
+        run = i + 1;
+
+        char* out = writer_reserve(writer, 6);
+        out[0] = '\\';
+        switch (c) {
+            case '"':  out[1] = '"';  writer->length += 2; break;
+            case '\\': out[1] = '\\'; writer->length += 2; break;
+            case '\n': out[1] = 'n';  writer->length += 2; break;
+            case '\r': out[1] = 'r';  writer->length += 2; break;
+            case '\t': out[1] = 't';  writer->length += 2; break;
+            default:
+                memcpy(out + 1, "u00", 3);
+                out[4] = HEX[c >> 4];
+                out[5] = HEX[c & 0xF];
+                writer->length += 6;
+                break;
+        }
+    }
+    writer_put(writer, text + run, length - run);
+    writer_put(writer, "\"", 1);
+}
+
+// Shortest "%.*g" that reads back as the same double, so 0.1 prints as
+// 0.1 rather than 0.10000000000000001
+static void writer_double(DumpWriter* writer, double value) {
+    char* out = writer_reserve(writer, 32);
+    int n = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        n = snprintf(out, 32, "%.*g", precision, value);
+        if (strtod(out, NULL) == value) break;
+    }
+    writer->length += (size_t)n;
+}
+
+static void dump_jsonl(Lexer* lexer, DumpWriter* writer) {
+    const char* names[TOKEN_TYPE_COUNT];
+    size_t name_lengths[TOKEN_TYPE_COUNT];
+    for (int type = 0; type < TOKEN_TYPE_COUNT; type++) {
+        names[type] = token_type_to_string((Token)type);
+        name_lengths[type] = strlen(names[type]);
+    }
+
+    for (size_t i = 0; i < lexer->tokens.count; i++) {
+        TokenData token = lexer_token_view(lexer, i);
+        size_t offset = token_store_offset(&lexer->tokens, i);
+        Location loc = lexer_location(lexer, offset);
+
+        WRITE_LITERAL(writer, "{\"type\":\"");
+        writer_put(writer, names[token.type], name_lengths[token.type]);
+        WRITE_LITERAL(writer, "\",\"offset\":");
+        writer_u64(writer, offset);
+        WRITE_LITERAL(writer, ",\"line\":");
+        writer_u64(writer, loc.line);
+        WRITE_LITERAL(writer, ",\"col\":");
+        writer_u64(writer, loc.col);
+        WRITE_LITERAL(writer, ",\"text\":");
+        if (token.val) {
+            writer_json_string(writer, token.val, token.len);
+        } else {
+            WRITE_LITERAL(writer, "null");
+        }
+
+        if (token.type == TOKEN_INTEGER) {
+            WRITE_LITERAL(writer, ",\"value\":");
+            writer_i64(writer, token.number.i);
+        } else if (token.type == TOKEN_FLOAT) {
+            WRITE_LITERAL(writer, ",\"value\":");
+            if (isfinite(token.number.f)) {
+                writer_double(writer, token.number.f);
+            } else {
+                WRITE_LITERAL(writer, "null");
+            }
+        }
+        WRITE_LITERAL(writer, "}\n");
+    }
+}
+
+// ============================================================================
+// Binary
+// ============================================================================
+
+static void dump_binary(const Lexer* lexer, DumpWriter* writer) {
+    WRITE_LITERAL(writer, TOKEN_DUMP_MAGIC);
+    writer_le(writer, TOKEN_DUMP_BINARY_VERSION, 4);
+    writer_le(writer, TOKEN_TYPE_COUNT, 4);
+    for (int type = 0; type < TOKEN_TYPE_COUNT; type++) {
+        const char* name = token_type_to_string((Token)type);
+        size_t length = strlen(name);
+        writer_le(writer, length, 1);
+        writer_put(writer, name, length);
+    }
+    writer_le(writer, lexer->tokens.count, 8);
+
+    for (size_t i = 0; i < lexer->tokens.count; i++) {
+        TokenData token = lexer_token_view(lexer, i);
+        size_t length = token.val ? token.len : 0;
+
+        writer_le(writer, token.type, 1);
+        writer_le(writer, token_store_offset(&lexer->tokens, i), 4);
+        writer_le(writer, length, 4);
+        if (length > 0) writer_put(writer, token.val, length);
+
+        if (token.type == TOKEN_INTEGER) {
+            writer_le(writer, (uint64_t)token.number.i, 8);
+        } else if (token.type == TOKEN_FLOAT) {
+            uint64_t bits;
+            memcpy(&bits, &token.number.f, sizeof(bits));
+            writer_le(writer, bits, 8);
+        }
+    }
+}
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+int token_dump_format_parse(const char *name, TokenDumpFormat *format) {
+    if (strcmp(name, "table") == 0) {
+        *format = TOKEN_DUMP_TABLE;
+    } else if (strcmp(name, "jsonl") == 0) {
+        *format = TOKEN_DUMP_JSONL;
+    } else if (strcmp(name, "binary") == 0) {
+        *format = TOKEN_DUMP_BINARY;
+    } else {
+        return 1;
+    }
+    return 0;
+}
+
+int token_dump(Lexer *lexer, int fd, TokenDumpFormat format) {
+    DumpWriter writer = {fd, (char*)malloc(TOKEN_DUMP_BUFFER_SIZE), 0, 0};
+    if (!writer.buf) {
+        fprintf(stderr, "Fatal Error: Memory allocation failed for token dump\n");
+        exit(1);
+    }
+
+#ifdef _WIN32
+    // Text mode would turn every '\n' into "\r\n", even inside values
+    if (format == TOKEN_DUMP_BINARY) _setmode(fd, _O_BINARY);
+#endif
+
+    switch (format) {
+        case TOKEN_DUMP_TABLE:  dump_table(lexer, &writer); break;
+        case TOKEN_DUMP_JSONL:  dump_jsonl(lexer, &writer); break;
+        case TOKEN_DUMP_BINARY: dump_binary(lexer, &writer); break;
+    }
+
+    writer_flush(&writer);
+    free(writer.buf);
+    return writer.failed;
+}
@@ -0,0 +1,124 @@
+#include "utf8.h"
+
+// ============================================================================
+// Decoding and Encoding
+// ============================================================================
+
+size_t utf8_decode(const char* p, uint32_t* code_point) {
+    const unsigned char* s = (const unsigned char*)p;
+    unsigned char lead = s[0];
+    if (lead < 0x80) {
+        *code_point = lead;
+        return 1;
+    }
+
+    size_t length;
+    uint32_t value;
+    uint32_t min;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        value = lead & 0x1F;
+        min = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        value = lead & 0x0F;
+        min = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        value = lead & 0x07;
+        min = 0x10000;
+    } else {
+        return 0;
+    }
+
+    // Continuation bytes are 10xxxxxx, so the terminator ends the loop too
+    for (size_t i = 1; i < length; i++) {
+        if ((s[i] & 0xC0) != 0x80) return 0;
+        value = (value << 6) | (s[i] & 0x3F);
+    }
+    if (value < min || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+        return 0;
+    }
+
+    *code_point = value;
+    return length;
+}
+
+size_t utf8_encode(uint32_t code_point, char out[4]) {
+    if (code_point < 0x80) {
+        out[0] = (char)code_point;
+        return 1;
+    }
+    if (code_point < 0x800) {
+        out[0] = (char)(0xC0 | (code_point >> 6));
+        out[1] = (char)(0x80 | (code_point & 0x3F));
+        return 2;
+    }
+    if (code_point < 0x10000) {
+        out[0] = (char)(0xE0 | (code_point >> 12));
+        out[1] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (code_point & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (code_point >> 18));
+    out[1] = (char)(0x80 | ((code_point >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (code_point & 0x3F));
+    return 4;
+}
+
+// ============================================================================
+// Letters
+// ============================================================================
+
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+} LetterRange;
+
+// Sorted, non-overlapping
+static const LetterRange LETTERS[] = {
+    {0x0041, 0x005A}, {0x0061, 0x007A},
+    {0x00AA, 0x00AA}, {0x00B5, 0x00B5}, {0x00BA, 0x00BA},
+    {0x00C0, 0x00D6}, {0x00D8, 0x00F6}, {0x00F8, 0x02AF},   // Latin-1, Latin Extended, IPA
+    {0x0370, 0x0373}, {0x0376, 0x0377}, {0x037B, 0x037D},   // Greek
+    {0x0386, 0x0386}, {0x0388, 0x03FF},
+    {0x0400, 0x0481}, {0x048A, 0x052F},                     // Cyrillic
+    {0x0531, 0x0556}, {0x0561, 0x0587},                     // Armenian
+    {0x05D0, 0x05EA},                                       // Hebrew
+    {0x0620, 0x064A}, {0x0671, 0x06D3},                     // Arabic
+    {0x0904, 0x0939}, {0x0958, 0x0961},                     // Devanagari
+    {0x0E01, 0x0E30}, {0x0E40, 0x0E46},                     // Thai
+    {0x10A0, 0x10FF},                                       // Georgian
+    {0x1100, 0x11FF},                                       // Hangul Jamo
+    {0x1E00, 0x1FBC}, {0x1FC2, 0x1FCC}, {0x1FD0, 0x1FDB},   // Latin and Greek Extended
+    {0x1FE0, 0x1FEC}, {0x1FF2, 0x1FFC},
+    {0x3041, 0x3096}, {0x30A1, 0x30FA}, {0x30FC, 0x30FF},   // Hiragana, Katakana
+    {0x3400, 0x4DBF}, {0x4E00, 0x9FFF},                     // CJK ideographs
+    {0xAC00, 0xD7A3},                                       // Hangul syllables
+    {0xF900, 0xFAFF},                                       // CJK compatibility
+    {0xFF21, 0xFF3A}, {0xFF41, 0xFF5A}, {0xFF66, 0xFF9F},   // Fullwidth and halfwidth forms
+    {0x20000, 0x2FFFF},                                     // CJK ideographs, supplementary
+};
+
+int utf8_is_letter(uint32_t code_point) {
+    size_t lo = 0;
+    size_t hi = sizeof(LETTERS) / sizeof(LETTERS[0]);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (code_point < LETTERS[mid].first) {
+            hi = mid;
+        } else if (code_point > LETTERS[mid].last) {
+            lo = mid + 1;
+        } else {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+size_t utf8_letter_length(const char* p) {
+    uint32_t code_point;
+    size_t length = utf8_decode(p, &code_point);
+    return length > 0 && utf8_is_letter(code_point) ? length : 0;
+}